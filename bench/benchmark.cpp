@@ -0,0 +1,386 @@
+// Headless benchmark of the load and per-frame hot paths, reports JSON on stdout (or --output <file>)
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <numbers>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "ContourCache.h"
+#include "FourierCircles.h"
+#include "fft.h"
+#include "svg.h"
+
+#ifndef BENCH_ASSET_DIR
+#define BENCH_ASSET_DIR "assets/svg"
+#endif
+
+using geometry::Vec2f;
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    constexpr std::size_t SAMPLE_COUNTS[] = {100, 128, 1000, 1024, 10000, 16384};
+    constexpr std::size_t MIN_ITERATIONS = 5;
+    constexpr std::size_t MAX_ITERATIONS = 100000;
+
+    // Same sizing rule as regenerateContour in main.cpp
+    constexpr std::size_t CONTOUR_SAMPLES_MIN = 2048;
+    constexpr std::size_t CONTOUR_SAMPLES_MAX = 65536;
+    constexpr std::size_t CONTOUR_SAMPLES_PER_VECTOR = 4;
+    constexpr float VIEWPORT_W = 2560.0f;
+    constexpr float VIEWPORT_H = 1440.0f;
+
+    struct Options
+    {
+        double minTime = 0.2; // seconds per case
+        std::string filter;
+        std::string assets = BENCH_ASSET_DIR;
+        std::string output;
+    };
+
+    struct Param
+    {
+        std::string key;
+        std::string value; // already JSON encoded
+    };
+
+    struct Result
+    {
+        std::string name;
+        std::vector<Param> params;
+        std::string item; // unit counted by items_per_s
+        double itemsPerRun = 0.0;
+        std::vector<double> samples; // seconds per run
+    };
+
+    std::string jsonString(const std::string_view text)
+    {
+        std::string out = "\"";
+        for (const char c : text)
+        {
+            if (c == '"' || c == '\\') out += '\\';
+            if (static_cast<unsigned char>(c) < 0x20) continue;
+            out += c;
+        }
+        return out + "\"";
+    }
+
+    Param param(std::string key, const std::size_t value) { return {std::move(key), std::to_string(value)}; }
+    Param param(std::string key, const bool value) { return {std::move(key), value ? "true" : "false"}; }
+    Param param(std::string key, const std::string_view value) { return {std::move(key), jsonString(value)}; }
+
+    class Runner
+    {
+    public:
+        explicit Runner(Options options) : m_options(std::move(options)) {}
+
+        // Times `run` until minTime has passed (at least MIN_ITERATIONS runs)
+        void measure(std::string name, std::vector<Param> params, std::string item, const double itemsPerRun,
+                     const std::function<void()>& run)
+        {
+            if (!m_options.filter.empty() && name.find(m_options.filter) == std::string::npos) return;
+
+            Result result{std::move(name), std::move(params), std::move(item), itemsPerRun, {}};
+            run(); // warm-up: plans, caches, page faults
+
+            double total = 0.0;
+            while ((total < m_options.minTime || result.samples.size() < MIN_ITERATIONS) &&
+                result.samples.size() < MAX_ITERATIONS)
+            {
+                const auto start = Clock::now();
+                run();
+                const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+                result.samples.push_back(elapsed);
+                total += elapsed;
+            }
+            std::cerr << result.name << " " << result.samples.size() << " runs\n";
+            m_results.push_back(std::move(result));
+        }
+
+        void write(std::ostream& out) const
+        {
+            out << std::setprecision(6);
+            out << "{\n  \"benchmark\": \"fourier_bench\",\n";
+            out << "  \"simd\": " << jsonString(simdName()) << ",\n";
+            out << "  \"min_time_s\": " << m_options.minTime << ",\n";
+            out << "  \"results\": [";
+            for (std::size_t r = 0; r < m_results.size(); ++r)
+            {
+                const Result& result = m_results[r];
+                std::vector<double> sorted = result.samples;
+                std::ranges::sort(sorted);
+                double sum = 0.0;
+                for (const double s : sorted) sum += s;
+                const double mean = sum / static_cast<double>(sorted.size());
+
+                out << (r ? ",\n" : "\n") << "    {\"name\": " << jsonString(result.name) << ", \"params\": {";
+                for (std::size_t p = 0; p < result.params.size(); ++p)
+                {
+                    out << (p ? ", " : "") << jsonString(result.params[p].key) << ": " << result.params[p].value;
+                }
+                out << "}, \"iterations\": " << sorted.size();
+                out << ", \"mean_us\": " << mean * 1e6;
+                out << ", \"min_us\": " << sorted.front() * 1e6;
+                out << ", \"p50_us\": " << percentile(sorted, 0.50) * 1e6;
+                out << ", \"p90_us\": " << percentile(sorted, 0.90) * 1e6;
+                out << ", \"p99_us\": " << percentile(sorted, 0.99) * 1e6;
+                out << ", \"max_us\": " << sorted.back() * 1e6;
+                out << ", \"item\": " << jsonString(result.item);
+                out << ", \"items_per_s\": " << result.itemsPerRun / mean << "}";
+            }
+            out << "\n  ]\n}\n";
+        }
+
+    private:
+        // Nearest-rank percentile of sorted samples
+        static double percentile(const std::vector<double>& sorted, const double q)
+        {
+            const auto rank = static_cast<std::size_t>(std::ceil(q * static_cast<double>(sorted.size())));
+            return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+        }
+
+        static std::string_view simdName()
+        {
+#if defined(FFT_SIMD_AVX2)
+            return "avx2";
+#elif defined(FFT_SIMD_WASM)
+            return "wasm_simd128";
+#elif defined(FFT_SIMD_SSE2)
+            return "sse2";
+#elif defined(FFT_SIMD_NEON)
+            return "neon";
+#else
+            return "scalar";
+#endif
+        }
+
+        Options m_options;
+        std::vector<Result> m_results;
+    };
+
+    // A closed random-ish blob with enough curvature to exercise resampling
+    std::vector<Vec2f> syntheticPoints(const std::size_t n)
+    {
+        std::vector<Vec2f> points(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const float a = 2.0f * std::numbers::pi_v<float> * static_cast<float>(i) / static_cast<float>(n);
+            const float r = 300.0f + 40.0f * std::sin(7.0f * a) + 15.0f * std::cos(31.0f * a);
+            points[i] = {r * std::cos(a), r * std::sin(a)};
+        }
+        return points;
+    }
+
+    // `paths` paths of `cubics` random cubic segments each, for load paths much heavier than the bundled drawings
+    std::string syntheticSvg(const std::size_t paths, const std::size_t cubics)
+    {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> step(-20.0f, 20.0f);
+        std::ostringstream svg;
+        svg << std::fixed << std::setprecision(2);
+        svg << R"(<svg xmlns="http://www.w3.org/2000/svg" width="1000" height="1000">)";
+        for (std::size_t p = 0; p < paths; ++p)
+        {
+            float x = 500.0f, y = 500.0f;
+            svg << R"(<path fill="none" stroke="black" d="M)" << x << ',' << y;
+            for (std::size_t c = 0; c < cubics; ++c)
+            {
+                svg << " C";
+                for (int k = 0; k < 3; ++k)
+                {
+                    x = std::clamp(x + step(rng), 0.0f, 1000.0f);
+                    y = std::clamp(y + step(rng), 0.0f, 1000.0f);
+                    svg << ' ' << x << ',' << y;
+                }
+            }
+            svg << R"( Z"/>)";
+        }
+        svg << "</svg>";
+        return svg.str();
+    }
+
+    void benchFft(Runner& runner)
+    {
+        for (const std::size_t n : SAMPLE_COUNTS)
+        {
+            const bool pow2 = std::has_single_bit(n);
+            const std::vector<Vec2f> input = syntheticPoints(n);
+            std::vector<Vec2f> output(n);
+            for (const auto direction : {fft::FFTDirection::Forward, fft::FFTDirection::Inverse})
+            {
+                const bool forward = direction == fft::FFTDirection::Forward;
+                const fft::FFT plan(n, direction);
+                runner.measure(forward ? "fft.forward" : "fft.inverse",
+                               {param("n", n), param("pow2", pow2)}, "points", static_cast<double>(n),
+                               [&] { plan.execute(input, output); });
+            }
+            runner.measure("fft.plan", {param("n", n), param("pow2", pow2)}, "plans", 1.0,
+                           [&] { const fft::FFT plan(n, fft::FFTDirection::Forward); (void)plan.size(); });
+            runner.measure("fft.plan_cached", {param("n", n), param("pow2", pow2)}, "plans", 1.0,
+                           [&] { (void)fft::plan(n, fft::FFTDirection::Forward).size(); });
+        }
+    }
+
+    void benchSvg(Runner& runner, const std::string& name, const std::string& text)
+    {
+        runner.measure("svg.flatten", {param("svg", name)}, "bytes", static_cast<double>(text.size()),
+                       [&] { (void)svg::flattenSVGFromString(text); });
+
+        const svg::FlattenedPath flattened = svg::flattenSVGFromString(text);
+        if (flattened.empty())
+        {
+            std::cerr << "Skipping resample of " << name << ": no drawable paths\n";
+            return;
+        }
+        for (const std::size_t n : SAMPLE_COUNTS)
+        {
+            runner.measure("svg.resample", {param("svg", name), param("n", n)}, "points", static_cast<double>(n),
+                           [&] { (void)svg::resample(flattened, n); });
+        }
+    }
+
+    void benchSvgFiles(Runner& runner, const std::string& directory)
+    {
+        std::error_code ec;
+        std::vector<std::filesystem::path> files;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, ec))
+        {
+            if (entry.path().extension() == ".svg") files.push_back(entry.path());
+        }
+        if (ec) std::cerr << "Cannot list " << directory << ": " << ec.message() << "\n";
+        std::ranges::sort(files);
+
+        for (const auto& file : files)
+        {
+            std::ifstream in(file, std::ios::binary);
+            std::ostringstream ss;
+            ss << in.rdbuf();
+            benchSvg(runner, file.filename().string(), ss.str());
+        }
+
+        benchSvg(runner, "synthetic_1x10000", syntheticSvg(1, 10000));
+        benchSvg(runner, "synthetic_1000x16", syntheticSvg(1000, 16));
+    }
+
+    void benchFourierCircles(Runner& runner)
+    {
+        for (const std::size_t n : SAMPLE_COUNTS)
+        {
+            const bool pow2 = std::has_single_bit(n);
+            const std::vector<Vec2f> points = syntheticPoints(n);
+            FourierCircles fc;
+
+            runner.measure("circles.calculateCoefficients", {param("n", n), param("pow2", pow2)}, "points",
+                           static_cast<double>(n), [&] { fc.calculateCoefficients(points); });
+            runner.measure("circles.calculateCoefficients+order", {param("n", n), param("pow2", pow2)}, "points",
+                           static_cast<double>(n), [&]
+                           {
+                               fc.calculateCoefficients(points);
+                               fc.orderCoefficients(n);
+                           });
+
+            fc.calculateCoefficients(points);
+            float t = 0.0f;
+            runner.measure("circles.calculateVectors", {param("n", n), param("pow2", pow2)}, "vectors",
+                           static_cast<double>(n), [&]
+                           {
+                               fc.calculateVectors(t, n);
+                               t = std::fmod(t + 1.0f / 14400.0f, 1.0f);
+                           });
+
+            // One simulation tick per call, as SDL_AppIterate does at 240 Hz
+            constexpr float dt = 1.0f / 14400.0f;
+            float step_t = 0.0f;
+            fc.calculateVectors(step_t, n);
+            runner.measure("circles.stepVectors", {param("n", n), param("pow2", pow2)}, "vectors",
+                           static_cast<double>(n), [&]
+                           {
+                               step_t += dt;
+                               fc.stepVectors(step_t, dt, 1, n);
+                           });
+        }
+    }
+
+    void benchContour(Runner& runner)
+    {
+        for (const std::size_t n : SAMPLE_COUNTS)
+        {
+            const bool pow2 = std::has_single_bit(n);
+            const std::vector<Vec2f> points = syntheticPoints(n);
+            FourierCircles fc;
+            fc.calculateCoefficients(points);
+            const std::size_t samples = std::clamp(n * CONTOUR_SAMPLES_PER_VECTOR, CONTOUR_SAMPLES_MIN,
+                                                   CONTOUR_SAMPLES_MAX);
+
+            ContourCache contour;
+            runner.measure("contour.build", {param("n", n), param("pow2", pow2)}, "samples",
+                           static_cast<double>(samples), [&] { contour.build(fc, n, samples); });
+
+            // Steady-state frames once refinement for the zoom level has settled
+            for (const float zoom : {1.0f, 100.0f})
+            {
+                const Vec2f offset = Vec2f{VIEWPORT_W, VIEWPORT_H} / 2.0f - points.front() * zoom;
+                contour.build(fc, n, samples);
+                for (int frame = 0; frame < 64; ++frame)
+                {
+                    contour.tessellate(fc, zoom, offset, VIEWPORT_W, VIEWPORT_H);
+                }
+                runner.measure("contour.tessellate",
+                               {param("n", n), param("pow2", pow2), param("zoom", static_cast<std::size_t>(zoom))},
+                               "points", static_cast<double>(contour.points().size()),
+                               [&] { contour.tessellate(fc, zoom, offset, VIEWPORT_W, VIEWPORT_H); });
+            }
+        }
+    }
+} // namespace
+
+int main(const int argc, char* argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--min-time" && hasValue) options.minTime = std::stod(argv[++i]);
+        else if (arg == "--filter" && hasValue) options.filter = argv[++i];
+        else if (arg == "--assets" && hasValue) options.assets = argv[++i];
+        else if (arg == "--output" && hasValue) options.output = argv[++i];
+        else
+        {
+            std::cerr << "Usage: " << argv[0]
+                << " [--min-time <seconds>] [--filter <substring>] [--assets <svg dir>] [--output <file.json>]\n";
+            return 1;
+        }
+    }
+
+    Runner runner(options);
+    benchFft(runner);
+    benchSvgFiles(runner, options.assets);
+    benchFourierCircles(runner);
+    benchContour(runner);
+
+    if (options.output.empty())
+    {
+        runner.write(std::cout);
+        return 0;
+    }
+    std::ofstream out(options.output, std::ios::trunc);
+    if (!out)
+    {
+        std::cerr << "Cannot write " << options.output << "\n";
+        return 2;
+    }
+    runner.write(out);
+    return 0;
+}
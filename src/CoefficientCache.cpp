@@ -0,0 +1,263 @@
+#include "CoefficientCache.h"
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <system_error>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace coefficient_cache
+{
+    namespace
+    {
+        constexpr char MAGIC[4] = {'F', 'C', 'C', '1'};
+        constexpr std::uint32_t VERSION = 1;
+
+        struct Header
+        {
+            char magic[4];
+            std::uint32_t version;
+            std::uint64_t sourceHash;
+            std::uint32_t sampleCount;
+            float offsetX;
+            float scale;
+            std::uint32_t pointCount;
+            std::uint32_t coefficientCount;
+            std::uint32_t reserved;
+        };
+        static_assert(sizeof(Header) == 40, "cache header layout changed");
+
+        template <typename T>
+        void append(std::vector<std::byte>& out, const std::span<const T> values)
+        {
+            const auto bytes = std::as_bytes(values);
+            out.insert(out.end(), bytes.begin(), bytes.end());
+        }
+
+        template <typename T>
+        void read(const std::byte*& cursor, std::vector<T>& out, const std::size_t count)
+        {
+            out.resize(count);
+            std::memcpy(out.data(), cursor, count * sizeof(T));
+            cursor += count * sizeof(T);
+        }
+
+        // Read-only view of a whole file, memory mapped where the platform allows
+        class MappedFile
+        {
+        public:
+            explicit MappedFile(const std::string& path)
+            {
+#if defined(_WIN32)
+                m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                     FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (m_file == INVALID_HANDLE_VALUE) return;
+                LARGE_INTEGER size;
+                if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) return;
+                m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (!m_mapping) return;
+                m_data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+                if (m_data) m_size = static_cast<std::size_t>(size.QuadPart);
+#elif !defined(__EMSCRIPTEN__)
+                m_fd = open(path.c_str(), O_RDONLY);
+                if (m_fd < 0) return;
+                struct stat st{};
+                if (fstat(m_fd, &st) != 0 || st.st_size == 0) return;
+                void* data = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, m_fd, 0);
+                if (data == MAP_FAILED) return;
+                m_data = data;
+                m_size = static_cast<std::size_t>(st.st_size);
+#else
+                // MEMFS / IDBFS files already live in memory, a plain read is as good as a mapping
+                std::ifstream file(path, std::ios::binary | std::ios::ate);
+                if (!file) return;
+                m_buffer.resize(static_cast<std::size_t>(file.tellg()));
+                file.seekg(0, std::ios::beg);
+                if (!file.read(reinterpret_cast<char*>(m_buffer.data()), static_cast<std::streamsize>(m_buffer.size())))
+                {
+                    m_buffer.clear();
+                }
+#endif
+            }
+
+            ~MappedFile()
+            {
+#if defined(_WIN32)
+                if (m_data) UnmapViewOfFile(m_data);
+                if (m_mapping) CloseHandle(m_mapping);
+                if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+#elif !defined(__EMSCRIPTEN__)
+                if (m_data) munmap(m_data, m_size);
+                if (m_fd >= 0) close(m_fd);
+#endif
+            }
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            [[nodiscard]] std::span<const std::byte> bytes() const
+            {
+#if defined(__EMSCRIPTEN__)
+                return m_buffer;
+#else
+                return {static_cast<const std::byte*>(m_data), m_size};
+#endif
+            }
+
+        private:
+#if defined(_WIN32)
+            HANDLE m_file = INVALID_HANDLE_VALUE;
+            HANDLE m_mapping = nullptr;
+#elif !defined(__EMSCRIPTEN__)
+            int m_fd = -1;
+#endif
+#if defined(__EMSCRIPTEN__)
+            std::vector<std::byte> m_buffer;
+#else
+            void* m_data = nullptr;
+            std::size_t m_size = 0;
+#endif
+        };
+    } // namespace
+
+    std::uint64_t hashSource(std::string_view source)
+    {
+        constexpr std::string_view WHITESPACE = " \t\r\n";
+        const std::size_t first = source.find_first_not_of(WHITESPACE);
+        if (first == std::string_view::npos) source = {};
+        else source = source.substr(first, source.find_last_not_of(WHITESPACE) - first + 1);
+
+        std::uint64_t hash = 14695981039346656037ull;
+        for (const char c : source)
+        {
+            if (c == '\r') continue;
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    Key makeKey(const std::string_view source, const int sampleCount, const float offsetX, const float scale)
+    {
+        return makeKey(hashSource(source), sampleCount, offsetX, scale);
+    }
+
+    Key makeKey(const std::uint64_t sourceHash, const int sampleCount, const float offsetX, const float scale)
+    {
+        return {sourceHash, static_cast<std::uint32_t>(sampleCount), offsetX, scale};
+    }
+
+    std::string fileName(const Key& key)
+    {
+        return std::format("{:016x}-{}.fcc", key.sourceHash, key.sampleCount);
+    }
+
+    std::vector<std::byte> serialize(const Key& key, const std::span<const geometry::Vec2f> points,
+                                     FourierCircles& circles)
+    {
+        circles.orderCoefficients(circles.size());
+        const auto re = circles.getSortedRe();
+        const auto im = circles.getSortedIm();
+        const auto freq = circles.getSortedFrequencies();
+
+        std::vector<std::int32_t> k(freq.size());
+        for (std::size_t i = 0; i < freq.size(); ++i) k[i] = static_cast<std::int32_t>(freq[i]);
+
+        std::vector<float> xy;
+        xy.reserve(points.size() * 2);
+        for (const auto& p : points)
+        {
+            xy.push_back(p.x);
+            xy.push_back(p.y);
+        }
+
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.sourceHash = key.sourceHash;
+        header.sampleCount = key.sampleCount;
+        header.offsetX = key.offsetX;
+        header.scale = key.scale;
+        header.pointCount = static_cast<std::uint32_t>(points.size());
+        header.coefficientCount = static_cast<std::uint32_t>(k.size());
+
+        std::vector<std::byte> out;
+        out.reserve(sizeof(Header) + (xy.size() + 3 * k.size()) * 4);
+        append(out, std::span<const Header>(&header, 1));
+        append(out, std::span<const float>(xy));
+        append(out, re);
+        append(out, im);
+        append(out, std::span<const std::int32_t>(k));
+        return out;
+    }
+
+    bool deserialize(const std::span<const std::byte> data, const Key& key, Snapshot& out)
+    {
+        if (data.size() < sizeof(Header)) return false;
+
+        Header header;
+        std::memcpy(&header, data.data(), sizeof(Header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) return false;
+        if (Key{header.sourceHash, header.sampleCount, header.offsetX, header.scale} != key) return false;
+
+        const std::size_t points = header.pointCount;
+        const std::size_t count = header.coefficientCount;
+        if (data.size() != sizeof(Header) + (points * 2 + count * 3) * 4) return false;
+
+        const std::byte* cursor = data.data() + sizeof(Header);
+        std::vector<float> xy, re, im;
+        std::vector<std::int32_t> k;
+        read(cursor, xy, points * 2);
+        read(cursor, re, count);
+        read(cursor, im, count);
+        read(cursor, k, count);
+
+        // Every frequency must name a bin of a size-count spectrum
+        const auto limit = static_cast<std::int64_t>(count);
+        for (const std::int32_t f : k)
+        {
+            if (f <= -limit || f >= limit) return false;
+        }
+
+        out.points.resize(points);
+        for (std::size_t i = 0; i < points; ++i) out.points[i] = {xy[2 * i], xy[2 * i + 1]};
+        out.circles.restoreCoefficients(re, im, k);
+        return true;
+    }
+
+    bool load(const std::string& path, const Key& key, Snapshot& out)
+    {
+        const MappedFile file(path);
+        return deserialize(file.bytes(), key, out);
+    }
+
+    bool store(const std::string& path, const std::span<const std::byte> data)
+    {
+        const std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file) return false;
+            if (!file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size())))
+                return false;
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(temporary, path, ec);
+        if (ec)
+        {
+            std::filesystem::remove(temporary, ec);
+            return false;
+        }
+        return true;
+    }
+} // namespace coefficient_cache
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "FourierCircles.h"
+#include "Vec2.h"
+
+// Binary snapshot of a loaded drawing: the resampled points and the coefficients in descending magnitude order, so
+// a repeated load skips parsing, the FFT and the sort. Files are keyed by the SVG source and every parameter that
+// shapes the result; a snapshot whose key does not match is ignored.
+//
+// Layout (native endianness, all fields 4-byte aligned):
+//   Header
+//   float points[pointCount][2]
+//   float re[coefficientCount], im[coefficientCount]
+//   int32 k[coefficientCount]       (signed frequency)
+namespace coefficient_cache
+{
+    struct Key
+    {
+        std::uint64_t sourceHash = 0;
+        std::uint32_t sampleCount = 0;
+        float offsetX = 0.0f;
+        float scale = 1.0f;
+
+        bool operator==(const Key&) const = default;
+    };
+
+    struct Snapshot
+    {
+        std::vector<geometry::Vec2f> points;
+        FourierCircles circles;
+    };
+
+    // FNV-1a over the SVG text with surrounding whitespace trimmed and carriage returns skipped, so a file and its
+    // embed_text copy hash the same
+    [[nodiscard]] std::uint64_t hashSource(std::string_view source);
+
+    [[nodiscard]] Key makeKey(std::string_view source, int sampleCount, float offsetX, float scale);
+    [[nodiscard]] Key makeKey(std::uint64_t sourceHash, int sampleCount, float offsetX, float scale);
+
+    // "<hash>-<samples>.fcc", the file name of a key inside a cache directory
+    [[nodiscard]] std::string fileName(const Key& key);
+
+    // Orders every coefficient of `circles` and serializes them with the points
+    [[nodiscard]] std::vector<std::byte> serialize(const Key& key, std::span<const geometry::Vec2f> points,
+                                                   FourierCircles& circles);
+
+    // Returns false if `data` is not a well-formed snapshot for `key`
+    [[nodiscard]] bool deserialize(std::span<const std::byte> data, const Key& key, Snapshot& out);
+
+    // Maps (or on the web, reads) the file and deserializes it
+    [[nodiscard]] bool load(const std::string& path, const Key& key, Snapshot& out);
+
+    // Writes through a temporary file and a rename so a concurrent reader never sees a partial snapshot
+    [[nodiscard]] bool store(const std::string& path, std::span<const std::byte> data);
+} // namespace coefficient_cache
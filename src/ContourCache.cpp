@@ -0,0 +1,153 @@
+#include "ContourCache.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+using geometry::Vec2f;
+
+void ContourCache::build(FourierCircles& fc, const std::size_t count, const std::size_t coarseSamples)
+{
+    m_levels.clear();
+    m_tiles.clear();
+    m_screen.clear();
+    m_runs.clear();
+    m_refinedGrids = 0;
+    m_refining = false;
+    ++m_generation;
+    m_count = count;
+
+    FourierCircles::Vector coarse;
+    fc.synthesizeContour(count, coarseSamples, coarse);
+    if (coarse.size() < 2)
+    {
+        m_samples = 0;
+        return;
+    }
+
+    m_samples = coarse.size() - 1;
+    m_maxRefinement = std::max<std::size_t>(1, std::bit_floor(FINE_SAMPLES_MAX / m_samples));
+    m_levels.resize(m_maxRefinement);
+    m_levels[0] = std::move(coarse);
+
+    // Bounds grow by the longest segment, the finer grids can bulge past the coarse chords by about that much
+    const auto& points = m_levels[0];
+    const std::size_t segments = std::min(TILE_SEGMENTS, m_samples);
+    m_tiles.resize(m_samples / segments);
+    for (std::size_t t = 0; t < m_tiles.size(); ++t)
+    {
+        const std::size_t first = t * segments;
+        Vec2f lo = points[first];
+        Vec2f hi = points[first];
+        float length = 0.0f;
+        float longest = 0.0f;
+        for (std::size_t i = first + 1; i <= first + segments; ++i)
+        {
+            lo = {std::min(lo.x, points[i].x), std::min(lo.y, points[i].y)};
+            hi = {std::max(hi.x, points[i].x), std::max(hi.y, points[i].y)};
+            const float step = (points[i] - points[i - 1]).length();
+            length += step;
+            longest = std::max(longest, step);
+        }
+        m_tiles[t] = {lo - Vec2f{longest, longest}, hi + Vec2f{longest, longest}, length};
+    }
+}
+
+std::size_t ContourCache::availableRefinement() const
+{
+    return std::min(m_maxRefinement, std::bit_floor(m_refinedGrids + 1));
+}
+
+void ContourCache::refine(FourierCircles& fc, const std::size_t refinement)
+{
+    // Grid c (1-based) belongs to refinement 2 * bit_floor(c) and is its s-th odd subdivision, so offsets fill in
+    // as 1/2, then 1/4 and 3/4, then the odd eighths, ...
+    std::size_t budget = FINE_SAMPLES_PER_FRAME;
+    while (availableRefinement() < refinement && budget >= m_samples)
+    {
+        const std::size_t c = m_refinedGrids + 1;
+        const std::size_t base = std::bit_floor(c);
+        const std::size_t s = 2 * (c - base) + 1;
+        const std::size_t offset = s * m_maxRefinement / (2 * base);
+
+        fc.synthesizeContour(m_count, m_samples, m_levels[offset],
+                             static_cast<double>(offset) / static_cast<double>(m_maxRefinement));
+        ++m_refinedGrids;
+        ++m_generation;
+        budget -= m_samples;
+    }
+}
+
+void ContourCache::tessellate(FourierCircles& fc, const float zoom, const Vec2f offset, const float viewportWidth,
+                              const float viewportHeight)
+{
+    m_screen.clear();
+    m_runs.clear();
+    if (m_levels.empty()) return;
+
+    const std::size_t segments = m_samples / m_tiles.size();
+
+    // Pass 1: visibility and the wanted segment count of every tile, 0 when off-screen
+    auto& wanted = m_wanted;
+    wanted.resize(m_tiles.size());
+    std::size_t refinement = 1;
+    for (std::size_t t = 0; t < m_tiles.size(); ++t)
+    {
+        const Tile& tile = m_tiles[t];
+        const Vec2f lo = tile.min * zoom + offset;
+        const Vec2f hi = tile.max * zoom + offset;
+        const bool visible = hi.x >= 0.0f && hi.y >= 0.0f && lo.x <= viewportWidth && lo.y <= viewportHeight;
+
+        wanted[t] = visible ? std::max(tile.length * zoom / SEGMENT_PIXELS, 1.0f) : 0.0f;
+        if (wanted[t] > static_cast<float>(segments))
+        {
+            const auto r = static_cast<std::size_t>(std::ceil(wanted[t] / static_cast<float>(segments)));
+            refinement = std::max(refinement, std::bit_ceil(std::min(r, m_maxRefinement)));
+        }
+    }
+
+    refine(fc, refinement);
+    const std::size_t available = availableRefinement();
+    m_refining = available < refinement;
+
+    // Pass 2: emit visible tiles; each tile's last point is the next one's first, so it is only written to close a run
+    const auto& coarse = m_levels[0];
+    auto emit = [&](const Vec2f& p) { m_screen.push_back(p * zoom + offset); };
+    for (std::size_t t = 0; t < m_tiles.size(); ++t)
+    {
+        if (wanted[t] == 0.0f) continue;
+
+        if (t == 0 || wanted[t - 1] == 0.0f)
+        {
+            m_runs.push_back({m_screen.size(), 0});
+        }
+
+        const std::size_t first = t * segments;
+        const std::size_t last = first + segments;
+        if (wanted[t] <= static_cast<float>(segments))
+        {
+            // Zoomed out: keep every step-th coarse point
+            const auto fit = static_cast<std::size_t>(static_cast<float>(segments) / wanted[t]);
+            const std::size_t step = std::clamp<std::size_t>(std::bit_floor(std::max<std::size_t>(fit, 1)), 1,
+                                                             segments);
+            for (std::size_t i = first; i < last; i += step) emit(coarse[i]);
+        }
+        else
+        {
+            // Zoomed in: interleave the shifted grids
+            const auto r = static_cast<std::size_t>(std::ceil(wanted[t] / static_cast<float>(segments)));
+            const std::size_t use = std::min(std::bit_ceil(std::min(r, m_maxRefinement)), available);
+            const std::size_t stride = m_maxRefinement / use;
+            for (std::size_t i = first; i < last; ++i)
+            {
+                for (std::size_t s = 0; s < use; ++s) emit(m_levels[s * stride][i]);
+            }
+        }
+
+        // Close the run if the next tile is not drawn
+        if (t + 1 == m_tiles.size() || wanted[t + 1] == 0.0f)
+        {
+            emit(coarse[last]);
+        }
+        m_runs.back().count = m_screen.size() - m_runs.back().first;
+    }
+}
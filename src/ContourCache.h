@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "FourierCircles.h"
+#include "Vec2.h"
+
+// Multi-resolution cache of the truncated contour. The coarse level is one inverse-FFT synthesis on M points; it is
+// split into tiles of TILE_SEGMENTS segments that carry their world-space bounds and length. Each frame only the
+// tiles inside the viewport are emitted, at a density matched to their on-screen length: coarse points are skipped
+// when zoomed out, and when zoomed in the tile interleaves finer grids. A refinement level r needs the r - 1 grids
+// shifted by 1/r of a coarse sample; each is one more synthesis of size M, computed when first needed and shared by
+// every tile.
+class ContourCache
+{
+public:
+    // Consecutive visible tiles, drawn as one polyline
+    struct Run
+    {
+        std::size_t first;
+        std::size_t count;
+    };
+
+    // Coarse segments per tile
+    static constexpr std::size_t TILE_SEGMENTS = 64;
+    // Target on-screen length of an emitted segment, in pixels
+    static constexpr float SEGMENT_PIXELS = 2.0f;
+    // Upper bound on the points held by all shifted grids together
+    static constexpr std::size_t FINE_SAMPLES_MAX = std::size_t{1} << 21;
+    // Points worth of shifted grids synthesized per tessellate() call, so a zoom jump refines over a few frames
+    static constexpr std::size_t FINE_SAMPLES_PER_FRAME = std::size_t{1} << 16;
+
+    // Synthesizes the coarse level for the first `count` vectors and drops all refinement
+    void build(FourierCircles& fc, std::size_t count, std::size_t coarseSamples);
+
+    // Collects the visible part of the contour in screen space for the camera mapping world p to p * zoom + offset
+    void tessellate(FourierCircles& fc, float zoom, geometry::Vec2f offset, float viewportWidth,
+                    float viewportHeight);
+
+    [[nodiscard]] bool empty() const { return m_levels.empty(); }
+    // Changes whenever build() or refinement changes the points tessellate() draws from
+    [[nodiscard]] std::uint64_t generation() const { return m_generation; }
+    // The last tessellate() wanted finer grids than it had; later calls will add them
+    [[nodiscard]] bool refining() const { return m_refining; }
+
+    // Output of the last tessellate()
+    [[nodiscard]] std::span<const geometry::Vec2f> points() const { return m_screen; }
+    [[nodiscard]] std::span<const Run> runs() const { return m_runs; }
+
+private:
+    struct Tile
+    {
+        geometry::Vec2f min;
+        geometry::Vec2f max;
+        float length;
+    };
+
+    // Highest refinement for which all needed shifted grids exist
+    [[nodiscard]] std::size_t availableRefinement() const;
+    // Synthesizes shifted grids until `refinement` is available or the per-frame budget is spent
+    void refine(FourierCircles& fc, std::size_t refinement);
+
+    std::size_t m_count = 0;
+    std::size_t m_samples = 0; // M, points per level
+    std::size_t m_maxRefinement = 1;
+
+    // m_levels[o] is the grid shifted by o / m_maxRefinement of a coarse sample, each M + 1 points; only offsets
+    // up to the current refinement are filled. m_levels[0] is the coarse level.
+    std::vector<FourierCircles::Vector> m_levels;
+    std::size_t m_refinedGrids = 0; // shifted grids computed so far, in the order refine() produces them
+    std::uint64_t m_generation = 0;
+    bool m_refining = false;
+
+    std::vector<Tile> m_tiles;
+    std::vector<float> m_wanted; // per tile segment count for the current frame, 0 when off-screen
+
+    std::vector<geometry::Vec2f> m_screen;
+    std::vector<Run> m_runs;
+};
@@ -0,0 +1,135 @@
+#include "EpicycleMesh.h"
+#include <algorithm>
+#include <cmath>
+
+using geometry::Vec2f;
+
+EpicycleMesh::EpicycleMesh(const Style style) : m_style(style)
+{
+    // Built up front so the writing pass only ever reads them
+    for (int n = m_style.minCircleSegments; n <= m_style.maxCircleSegments; ++n)
+    {
+        m_unitCircles.push_back(GeometryBatch::makeUnitCircle(n));
+    }
+}
+
+Vec2f EpicycleMesh::build(ThreadPool& pool, const std::span<const float> x, const std::span<const float> y,
+                          std::size_t count, const float zoom, const Vec2f offset, const float viewportWidth,
+                          const float viewportHeight, GeometryBatch& batch)
+{
+    count = std::min({count, x.size(), y.size()});
+    if (count == 0) return {0.0f, 0.0f};
+
+    const std::size_t chunks = count < PARALLEL_MIN_VECTORS
+                                   ? 1
+                                   : std::min(count, pool.concurrency() * ThreadPool::CHUNKS_PER_THREAD);
+    m_chunks.resize(chunks);
+    for (std::size_t c = 0; c < chunks; ++c) m_chunks[c] = {count * c / chunks, count * (c + 1) / chunks};
+    m_shapes.resize(count);
+
+    // Pass 1: the sum of every chunk's vectors, scanned into the chain position each chunk starts at
+    pool.parallelFor(chunks, [&](const std::size_t c)
+    {
+        Chunk& chunk = m_chunks[c];
+        float sx = 0.0f, sy = 0.0f;
+        for (std::size_t i = chunk.begin; i < chunk.end; ++i)
+        {
+            sx += x[i];
+            sy += y[i];
+        }
+        chunk.sum = {sx, sy};
+    });
+    Vec2f chain = {0.0f, 0.0f};
+    for (Chunk& chunk : m_chunks)
+    {
+        const Vec2f sum = chunk.sum;
+        chunk.sum = chain;
+        chain += sum;
+    }
+
+    // Pass 2: what each vector draws, counted per chunk and scanned into vertex and index offsets
+    pool.parallelFor(chunks, [&](const std::size_t c)
+    {
+        Chunk& chunk = m_chunks[c];
+        Vec2f start = chunk.sum;
+        std::size_t vertices = 0, indices = 0;
+        for (std::size_t i = chunk.begin; i < chunk.end; ++i)
+        {
+            const Vec2f v = {x[i], y[i]};
+            const Shape shape = m_shapes[i] = this->shape(start * zoom + offset, v, zoom, viewportWidth,
+                                                          viewportHeight);
+            vertices += shape.vertices();
+            indices += shape.indices();
+            start += v;
+        }
+        chunk.vertices = vertices;
+        chunk.indices = indices;
+    });
+    std::size_t totalVertices = 0, totalIndices = 0;
+    for (Chunk& chunk : m_chunks)
+    {
+        const std::size_t vertices = chunk.vertices, indices = chunk.indices;
+        chunk.vertices = totalVertices;
+        chunk.indices = totalIndices;
+        totalVertices += vertices;
+        totalIndices += indices;
+    }
+    if (totalVertices == 0) return chain;
+
+    // Pass 3: every chunk writes its circles and arms into its own slice of the batch, in chain order
+    const GeometryBatch::Reservation out = batch.reserve(totalVertices, totalIndices);
+    pool.parallelFor(chunks, [&](const std::size_t c)
+    {
+        const Chunk& chunk = m_chunks[c];
+        GeometryBatch::Reservation slice = {
+            out.vertices + chunk.vertices, out.indices + chunk.indices, out.base + static_cast<int>(chunk.vertices)
+        };
+
+        Vec2f start = chunk.sum;
+        for (std::size_t i = chunk.begin; i < chunk.end; ++i)
+        {
+            const Vec2f v = {x[i], y[i]};
+            write(slice, m_shapes[i], start * zoom + offset, (start + v) * zoom + offset, v, zoom, i);
+            start += v;
+        }
+    });
+    return chain;
+}
+
+EpicycleMesh::Shape EpicycleMesh::shape(const Vec2f center, const Vec2f v, const float zoom, const float viewportWidth,
+                                        const float viewportHeight) const
+{
+    const float length = v.length() * zoom;
+    Shape shape;
+    if (length >= m_style.minCircleRadius &&
+        !GeometryBatch::isOffscreen(center, length + m_style.circleWidth * 0.5f, viewportWidth, viewportHeight))
+    {
+        shape.segments = static_cast<int>(std::clamp(length * m_style.circleSegmentsPerPixel,
+                                                     static_cast<float>(m_style.minCircleSegments),
+                                                     static_cast<float>(m_style.maxCircleSegments)));
+    }
+    shape.arm = length > 0.0f &&
+        !GeometryBatch::isOffscreen(center + v * (zoom * 0.5f), length * 0.5f + m_style.armWidth * 0.5f,
+                                    viewportWidth, viewportHeight);
+    return shape;
+}
+
+void EpicycleMesh::write(GeometryBatch::Reservation& out, const Shape shape, const Vec2f center, const Vec2f end,
+                         const Vec2f v, const float zoom, const std::size_t index) const
+{
+    if (shape.segments)
+    {
+        const float radius = v.length() * zoom;
+        const float half = m_style.circleWidth * 0.5f;
+        out.writeRing(center, m_unitCircles[shape.segments - m_style.minCircleSegments], std::max(radius - half, 0.0f),
+                      radius + half, m_style.circle);
+    }
+    if (shape.arm)
+    {
+        // The quad was counted already, so a span rounded to nothing in screen space stays as a degenerate one
+        const Vec2f d = end - center;
+        const float span = d.length();
+        const Vec2f n = span > 0.0f ? Vec2f{-d.y, d.x} * (m_style.armWidth * 0.5f / span) : Vec2f{0.0f, 0.0f};
+        out.writeQuad(center, end, n, m_style.arms[index % m_style.arms.size()]);
+    }
+}
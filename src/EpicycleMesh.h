@@ -0,0 +1,87 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "GeometryBatch.h"
+#include "ThreadPool.h"
+#include "Vec2.h"
+
+// Turns the x / y vector arrays of FourierCircles into circle and arm geometry in three data-parallel passes over
+// chunks of the chain, the same shape a compute shader would take: per-chunk sums of the vectors, an exclusive scan
+// of those into each chunk's starting point, then per-vector culling and counting, a scan of the counts into vertex
+// and index offsets, and finally every chunk writing its vertices straight into slots reserved in the batch.
+// Short chains skip the pool and run as one chunk.
+class EpicycleMesh
+{
+public:
+    // How circles and arms look, for the main view and for the drawings of a Scene alike
+    struct Style
+    {
+        SDL_FColor circle;
+        std::span<const SDL_FColor> arms; // cycled through by vector index
+        float circleWidth;
+        float armWidth;
+        float minCircleRadius; // in pixels, smaller circles are not drawn
+        float circleSegmentsPerPixel;
+        int minCircleSegments;
+        int maxCircleSegments;
+    };
+
+    // What one vector draws once culled against the viewport
+    struct Shape
+    {
+        int segments = 0; // of its circle, 0 = not drawn
+        bool arm = false;
+
+        [[nodiscard]] std::size_t vertices() const
+        {
+            return GeometryBatch::RING_VERTICES_PER_SEGMENT * static_cast<std::size_t>(segments) +
+                (arm ? GeometryBatch::QUAD_VERTICES : 0);
+        }
+        [[nodiscard]] std::size_t indices() const
+        {
+            return GeometryBatch::RING_INDICES_PER_SEGMENT * static_cast<std::size_t>(segments) +
+                (arm ? GeometryBatch::QUAD_INDICES : 0);
+        }
+    };
+
+    // Chains shorter than this are meshed on the calling thread alone
+    static constexpr std::size_t PARALLEL_MIN_VECTORS = 1024;
+
+    explicit EpicycleMesh(Style style);
+
+    // Appends the first `count` vectors of the chain starting at the world origin, for the camera mapping world p to
+    // p * zoom + offset, and returns the world position of the chain's end
+    geometry::Vec2f build(ThreadPool& pool, std::span<const float> x, std::span<const float> y, std::size_t count,
+                          float zoom, geometry::Vec2f offset, float viewportWidth, float viewportHeight,
+                          GeometryBatch& batch);
+
+    // The per-vector steps of build(), for callers meshing chains one vector at a time. Both only read the mesh, so
+    // they may run concurrently. `center` is the vector's screen start point, `v` the vector in world units.
+    [[nodiscard]] Shape shape(geometry::Vec2f center, geometry::Vec2f v, float zoom, float viewportWidth,
+                              float viewportHeight) const;
+    // Writes shape.vertices() and shape.indices() worth of the vector ending on screen at `end` into `out`
+    void write(GeometryBatch::Reservation& out, Shape shape, geometry::Vec2f center, geometry::Vec2f end,
+               geometry::Vec2f v, float zoom, std::size_t index) const;
+
+private:
+    struct Chunk
+    {
+        std::size_t begin = 0;
+        std::size_t end = 0;
+        geometry::Vec2f sum{}; // of the chunk's vectors, then the chain position where it starts
+        std::size_t vertices = 0;
+        std::size_t indices = 0;
+    };
+
+    Style m_style;
+    // m_unitCircles[n - minCircleSegments] holds n points on the unit circle
+    std::vector<std::vector<geometry::Vec2f>> m_unitCircles;
+
+    // Per vector scratch, from the counting pass for the writing one
+    std::vector<Shape> m_shapes;
+    std::vector<Chunk> m_chunks;
+};
@@ -1,7 +1,12 @@
 #pragma once
 #include <algorithm>
+#include <bit>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
 #include <ranges>
+#include <span>
 #include <vector>
 #include <numbers>
 #include <random>
@@ -13,77 +18,344 @@ struct FourierCircles
     using Vec2f = geometry::Vec2f;
     using Vector = std::vector<Vec2f>;
 
+    // Steps stepVectors may take in one call before exact evaluation is cheaper (frames spanning several ticks)
+    static constexpr int MAX_STEP_MULTIPLE = 8;
+    // Rotations between magnitude renormalizations of the stepped vectors
+    static constexpr int RENORMALIZE_INTERVAL = 64;
+    // Smallest sorted prefix orderCoefficients builds
+    static constexpr size_t MIN_ORDERED_PREFIX = 256;
+
+    // Transforms the input and records the magnitude of every bin. The descending magnitude order is built lazily by
+    // orderCoefficients, so only the prefix that is actually evaluated gets sorted.
     void calculateCoefficients(const Vector& input)
     {
-        coefficients = fft(input);
-        sortedIndices.resize(coefficients.size());
-        std::iota(sortedIndices.begin(), sortedIndices.end(), 0);
-        std::ranges::sort(sortedIndices, [&](const size_t i, const size_t j)
+        transform(input);
+        indexCoefficients();
+    }
+
+    // Same as calculateCoefficients for a spectrum the caller already has, in FFT bin order and normalized by its size
+    void setCoefficients(const std::span<const Vec2f> spectrum)
+    {
+        coefficients.assign(spectrum.begin(), spectrum.end());
+        indexCoefficients();
+    }
+
+    // Makes sure the `count` largest coefficients are in descending magnitude order, stored as contiguous arrays so
+    // the per-frame loops below stream through memory instead of gathering through an index table. The prefix
+    // grows at least geometrically, so stepping the vector count up one by one stays amortized O(N log N).
+    void orderCoefficients(size_t count)
+    {
+        const size_t size = coefficients.size();
+        const size_t sorted = freq.size();
+        count = std::min(count, size);
+        if (count <= sorted) return;
+
+        const size_t target = std::min(size, std::max({count, 2 * sorted, MIN_ORDERED_PREFIX}));
+        const auto by_magnitude = [&](const uint32_t i, const uint32_t j)
+        {
+            return binMagnitudeSq[i] > binMagnitudeSq[j];
+        };
+
+        // Everything past `sorted` is already no larger than the prefix, so only that tail needs partitioning
+        const auto first = sortedIndices.begin() + static_cast<std::ptrdiff_t>(sorted);
+        const auto middle = sortedIndices.begin() + static_cast<std::ptrdiff_t>(target);
+        if (middle != sortedIndices.end())
+        {
+            std::nth_element(first, middle, sortedIndices.end(), by_magnitude);
+        }
+        std::sort(first, middle, by_magnitude);
+
+        amp_re.resize(target);
+        amp_im.resize(target);
+        freq.resize(target);
+        magnitude.resize(target);
+        for (size_t rank = sorted; rank < target; ++rank)
         {
-            return coefficients[i].length_sq() > coefficients[j].length_sq();
-        });
+            const size_t n = sortedIndices[rank];
+            amp_re[rank] = coefficients[n].x;
+            amp_im[rank] = coefficients[n].y;
+            freq[rank] = static_cast<float>(signedFrequency(n, size));
+            magnitude[rank] = std::sqrt(binMagnitudeSq[n]);
+        }
+    }
+
+    // Replaces the coefficients with a complete, already sorted set as saved from the accessors below (the
+    // coefficient cache), skipping the transform and the sort
+    void restoreCoefficients(const std::span<const float> re, const std::span<const float> im,
+                             const std::span<const int32_t> k)
+    {
+        const size_t size = k.size();
+        assert(re.size() == size && im.size() == size);
+
+        coefficients.assign(size, Vec2f{});
+        binMagnitudeSq.assign(size, 0.0f);
+        sortedIndices.resize(size);
+        amp_re.assign(re.begin(), re.end());
+        amp_im.assign(im.begin(), im.end());
+        freq.resize(size);
+        magnitude.resize(size);
+        for (size_t rank = 0; rank < size; ++rank)
+        {
+            const size_t n = k[rank] >= 0 ? static_cast<size_t>(k[rank]) : size - static_cast<size_t>(-k[rank]);
+            coefficients[n] = {re[rank], im[rank]};
+            binMagnitudeSq[n] = coefficients[n].length_sq();
+            sortedIndices[rank] = static_cast<uint32_t>(n);
+            freq[rank] = static_cast<float>(k[rank]);
+            magnitude[rank] = std::sqrt(binMagnitudeSq[n]);
+        }
+        resetStepping();
     }
 
+    [[nodiscard]] size_t size() const { return coefficients.size(); }
+
+    // Sorted prefix built so far: amplitudes and signed frequencies in descending magnitude order
+    [[nodiscard]] std::span<const float> getSortedRe() const { return amp_re; }
+    [[nodiscard]] std::span<const float> getSortedIm() const { return amp_im; }
+    [[nodiscard]] std::span<const float> getSortedFrequencies() const { return freq; }
+    [[nodiscard]] std::span<const float> getSortedMagnitudes() const { return magnitude; }
+
     [[nodiscard]] Vec2f getResult() const { return result; }
     [[nodiscard]] const Vector& getVectors() const { return vectors; }
+    // The same vectors as separate x / y arrays
+    [[nodiscard]] std::span<const float> getVectorsX() const { return vec_x; }
+    [[nodiscard]] std::span<const float> getVectorsY() const { return vec_y; }
 
-    void calculateVectors(const float t)
+    // Evaluates the first `count` sorted vectors at t exactly; the rest cost nothing and are not part of the result
+    void calculateVectors(const float t, const size_t count = SIZE_MAX)
     {
-        assert(coefficients.size() == sortedIndices.size());
-        constexpr float PI = std::numbers::pi_v<float>;
-        const size_t size = coefficients.size();
-        vectors.resize(size);
-        result = {0, 0};
+        orderCoefficients(count);
+        resizeVectors(std::min(count, size()));
+        evaluateVectors(t, 0, vec_x.size());
+        publishVectors();
 
-        if (size == 0) return;
+        resetStepping();
+        step_t = t;
+        step_valid = true;
+    }
 
-        const float two_pi_t = 2.0f * PI * t;
-        size_t index = 0;
-        for (const size_t n : sortedIndices)
+    // Stateful variant of calculateVectors for a clock that advances t in fixed steps of dt, `steps` of them since
+    // the previous call. While dt stays the same every cached vector is rotated by its constant per-frequency
+    // phasor instead of calling sincos, with the magnitudes renormalized every RENORMALIZE_INTERVAL rotations to
+    // keep rounding from drifting. A jump of t (seek, reset, wrap-around), a new dt (time scale change) or more than
+    // MAX_STEP_MULTIPLE steps at once fall back to exact evaluation; the phasors for a new dt are built right then.
+    void stepVectors(const float t, const float dt, const int steps, const size_t count = SIZE_MAX)
+    {
+        const size_t target = std::min(count, size());
+        const size_t cached = std::min(vec_x.size(), target);
+        orderCoefficients(target);
+
+        const float expected = step_t + static_cast<float>(steps) * dt;
+        const bool on_track = step_valid && std::abs(t - expected) <= 0.5f * dt;
+
+        resizeVectors(target);
+        if (!on_track || dt != step_dt || steps > MAX_STEP_MULTIPLE)
         {
-            // compute signed frequency k as int for negative values when n>size/2
-            const int k = (n <= (size >> 1)) ? static_cast<int>(n) : static_cast<int>(n) - static_cast<int>(size);
-            const float phase = two_pi_t * static_cast<float>(k);
+            evaluateVectors(t, 0, target);
+            steps_since_renormalize = 0;
+            step_valid = true;
+            if (dt != step_dt)
+            {
+                phasor_re.clear();
+                phasor_im.clear();
+            }
+            step_dt = dt;
+        }
+        else
+        {
+            rotateVectors(cached, steps);
+            // Newly activated vectors start out exact at the current t
+            evaluateVectors(t, cached, target);
+        }
+        step_t = t;
+        extendPhasors(target);
+        publishVectors();
+    }
+
+    // Evaluates the sum of the first `count` sorted vectors on the uniform grid t = j / M with a single inverse FFT
+    // of the truncated spectrum. M is a power of two, at least `min_samples` and the coefficient count (so no two
+    // frequencies alias). `out` receives M + 1 points, the last one repeating the first to close the loop.
+    // A nonzero `offset` shifts the grid to t = (j + offset) / M, which lets a caller interleave several grids into
+    // a finer one without a larger transform.
+    void synthesizeContour(const size_t count, const size_t min_samples, Vector& out, const double offset = 0.0)
+    {
+        if (size() == 0)
+        {
+            out.clear();
+            return;
+        }
 
-            const float a = coefficients[n].x;
-            const float b = coefficients[n].y;
+        const size_t M = std::bit_ceil(std::max(min_samples, size()));
+        orderCoefficients(count);
 
-            float s, c;
-            sincosf(phase, &s, &c);
-            const Vec2f vec{a * c - b * s, a * s + b * c};
-            result += vec;
-            vectors[index++] = vec;
+        spectrum.assign(M, Vec2f{});
+        const size_t end = std::min(count, size());
+        for (size_t rank = 0; rank < end; ++rank)
+        {
+            const auto k = static_cast<int>(freq[rank]);
+            const size_t bin = k >= 0 ? static_cast<size_t>(k) : M - static_cast<size_t>(-k);
+            Vec2f amp{amp_re[rank], amp_im[rank]};
+            if (offset != 0.0)
+            {
+                const double phase = 2.0 * std::numbers::pi * offset * k / static_cast<double>(M);
+                const auto c = static_cast<float>(std::cos(phase));
+                const auto s = static_cast<float>(std::sin(phase));
+                amp = {amp.x * c - amp.y * s, amp.x * s + amp.y * c};
+            }
+            spectrum[bin] = amp;
         }
+
+        // Unscaled inverse, so the output is the plain sum of the vectors
+        out.resize(M + 1);
+        fft::plan(M, fft::FFTDirection::Inverse).execute(spectrum, std::span(out).first(M), 1.0f);
+        out[M] = out[0];
     }
 
 private:
-    fft::FFT fft_plan{};
+    // Records the magnitude of every bin and drops the sorted prefix and the stepping state
+    void indexCoefficients()
+    {
+        const size_t size = coefficients.size();
+
+        binMagnitudeSq.resize(size);
+        for (size_t n = 0; n < size; ++n)
+        {
+            binMagnitudeSq[n] = coefficients[n].length_sq();
+        }
+
+        sortedIndices.resize(size);
+        std::iota(sortedIndices.begin(), sortedIndices.end(), 0);
+
+        amp_re.clear();
+        amp_im.clear();
+        freq.clear();
+        magnitude.clear();
+        resetStepping();
+    }
+
+    void resizeVectors(const size_t count)
+    {
+        vec_x.resize(count);
+        vec_y.resize(count);
+    }
+
+    void evaluateVectors(const float t, const size_t first, const size_t last)
+    {
+        constexpr float PI = std::numbers::pi_v<float>;
+        const float two_pi_t = 2.0f * PI * t;
+        for (size_t rank = first; rank < last; ++rank)
+        {
+            const float a = amp_re[rank];
+            const float b = amp_im[rank];
+
+            float s, c;
+            sincosf(two_pi_t * freq[rank], &s, &c);
+            vec_x[rank] = a * c - b * s;
+            vec_y[rank] = a * s + b * c;
+        }
+    }
 
-    [[nodiscard]] Vector fft(const Vector& input)
+    // Mirrors the SoA vectors into the interleaved `vectors` and sums them
+    void publishVectors()
     {
-        if (input.empty())
-            return {};
+        const size_t count = vec_x.size();
+        vectors.resize(count);
+        result = {0, 0};
+        for (size_t rank = 0; rank < count; ++rank)
+        {
+            vectors[rank] = {vec_x[rank], vec_y[rank]};
+            result += vectors[rank];
+        }
+    }
 
-        const auto N = input.size();
+    // Per-frequency rotation e^{2*pi*i*k*dt} for the sorted vectors up to `count`, in double so the step itself
+    // carries no phase bias
+    void extendPhasors(const size_t count)
+    {
+        for (size_t rank = phasor_re.size(); rank < count; ++rank)
+        {
+            const double phase = 2.0 * std::numbers::pi * static_cast<double>(step_dt) * static_cast<double>(freq[rank]);
+            phasor_re.push_back(static_cast<float>(std::cos(phase)));
+            phasor_im.push_back(static_cast<float>(std::sin(phase)));
+        }
+    }
 
-        if (fft_plan.size() == 0 || fft_plan.size() != N)
+    void rotateVectors(const size_t count, const int steps)
+    {
+        if (steps == 0) return;
+        for (int i = 0; i < steps; ++i)
         {
-            fft_plan = fft::FFT(N, fft::FFTDirection::Forward);
+            for (size_t rank = 0; rank < count; ++rank)
+            {
+                const float x = vec_x[rank];
+                const float y = vec_y[rank];
+                vec_x[rank] = x * phasor_re[rank] - y * phasor_im[rank];
+                vec_y[rank] = x * phasor_im[rank] + y * phasor_re[rank];
+            }
         }
-        Vector output(N);
-        fft_plan.execute(input, output);
 
-        // Normalize by N
-        const float invN = 1.0f / static_cast<float>(N);
-        for (int i = 0; i < N; ++i)
+        steps_since_renormalize += steps;
+        if (steps_since_renormalize >= RENORMALIZE_INTERVAL)
         {
-            output[i] *= invN;
+            for (size_t rank = 0; rank < count; ++rank)
+            {
+                const float len = std::sqrt(vec_x[rank] * vec_x[rank] + vec_y[rank] * vec_y[rank]);
+                const float fix = len > 0.0f ? magnitude[rank] / len : 1.0f;
+                vec_x[rank] *= fix;
+                vec_y[rank] *= fix;
+            }
+            steps_since_renormalize = 0;
         }
-        return output;
     }
 
+    void resetStepping()
+    {
+        step_valid = false;
+        step_dt = 0.0f;
+        steps_since_renormalize = 0;
+        phasor_re.clear();
+        phasor_im.clear();
+    }
+
+    // signed frequency k of bin n, negative for n > size/2
+    [[nodiscard]] static int signedFrequency(const size_t n, const size_t size)
+    {
+        return (n <= (size >> 1)) ? static_cast<int>(n) : static_cast<int>(n) - static_cast<int>(size);
+    }
+
+    // Forward transform of the input into `coefficients`, normalized by N, with a cached plan and no allocation
+    // once `coefficients` has grown to N
+    void transform(const Vector& input)
+    {
+        const size_t N = input.size();
+        coefficients.resize(N);
+        if (N == 0) return;
+        fft::plan(N, fft::FFTDirection::Forward).execute(input, coefficients, 1.0f / static_cast<float>(N));
+    }
+
+    // Unsorted spectrum, its squared magnitudes and magnitude order; only the first freq.size() entries of
+    // sortedIndices are sorted, the rest is an unordered tail of smaller coefficients
     std::vector<Vec2f> coefficients{};
-    std::vector<size_t> sortedIndices{};
+    std::vector<float> binMagnitudeSq{};
+    std::vector<uint32_t> sortedIndices{};
+
+    // Sorted prefix of the coefficients in descending magnitude order: amplitude, signed frequency k and |amplitude|
+    std::vector<float> amp_re{};
+    std::vector<float> amp_im{};
+    std::vector<float> freq{};
+    std::vector<float> magnitude{};
+
+    // Evaluated vectors, SoA working copy and the interleaved view handed out by getVectors
+    std::vector<float> vec_x{};
+    std::vector<float> vec_y{};
     Vector vectors{};
+    Vector spectrum{}; // zero-padded truncated spectrum for synthesizeContour
     Vec2f result{};
+
+    // stepVectors state: t of the cached vectors, the step the phasors rotate by (0 when none)
+    std::vector<float> phasor_re{};
+    std::vector<float> phasor_im{};
+    float step_t = 0.0f;
+    float step_dt = 0.0f;
+    int steps_since_renormalize = 0;
+    bool step_valid = false;
 };
@@ -0,0 +1,282 @@
+#include "FrameExporter.h"
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <format>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace
+{
+    constexpr std::size_t STORED_BLOCK_MAX = 65535;
+
+    constexpr std::array<std::uint32_t, 256> makeCrcTable()
+    {
+        std::array<std::uint32_t, 256> table{};
+        for (std::uint32_t n = 0; n < 256; ++n)
+        {
+            std::uint32_t c = n;
+            for (int k = 0; k < 8; ++k) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+        return table;
+    }
+
+    constexpr auto CRC_TABLE = makeCrcTable();
+
+    std::uint32_t crc32(const std::uint8_t* data, const std::size_t size, std::uint32_t crc = 0xFFFFFFFFu)
+    {
+        for (std::size_t i = 0; i < size; ++i) crc = CRC_TABLE[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return crc;
+    }
+
+    void adler32(std::uint32_t& a, std::uint32_t& b, const std::uint8_t* data, std::size_t size)
+    {
+        // 5552 bytes is the most both sums can take before the reduction overflows 32 bits
+        while (size > 0)
+        {
+            const std::size_t n = std::min<std::size_t>(size, 5552);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                a += data[i];
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+            data += n;
+            size -= n;
+        }
+    }
+
+    void putBE32(std::vector<std::uint8_t>& out, const std::uint32_t v)
+    {
+        out.push_back(static_cast<std::uint8_t>(v >> 24));
+        out.push_back(static_cast<std::uint8_t>(v >> 16));
+        out.push_back(static_cast<std::uint8_t>(v >> 8));
+        out.push_back(static_cast<std::uint8_t>(v));
+    }
+
+    void beginChunk(std::vector<std::uint8_t>& out, const char* type)
+    {
+        putBE32(out, 0); // length, patched by endChunk
+        out.insert(out.end(), type, type + 4);
+    }
+
+    void endChunk(std::vector<std::uint8_t>& out, const std::size_t start)
+    {
+        const auto length = static_cast<std::uint32_t>(out.size() - start - 8);
+        for (int i = 0; i < 4; ++i) out[start + i] = static_cast<std::uint8_t>(length >> (24 - 8 * i));
+        putBE32(out, crc32(out.data() + start + 4, length + 4) ^ 0xFFFFFFFFu);
+    }
+
+    // PNG with stored (uncompressed) deflate blocks: several times larger than a compressed one, but encoding is
+    // barely more than a copy, which keeps the writer ahead of the renderer. Pipe to ffmpeg for compact output.
+    void encodePng(std::vector<std::uint8_t>& out, const SDL_Surface* rgba)
+    {
+        const auto w = static_cast<std::uint32_t>(rgba->w);
+        const auto h = static_cast<std::uint32_t>(rgba->h);
+        const std::size_t rowBytes = 1 + static_cast<std::size_t>(w) * 4; // filter byte + pixels
+        const std::size_t rawSize = rowBytes * h;
+
+        out.clear();
+        out.reserve(64 + rawSize + (rawSize / STORED_BLOCK_MAX + 1) * 5);
+        constexpr std::uint8_t SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        out.insert(out.end(), SIGNATURE, SIGNATURE + 8);
+
+        std::size_t start = out.size();
+        beginChunk(out, "IHDR");
+        putBE32(out, w);
+        putBE32(out, h);
+        out.insert(out.end(), {8, 6, 0, 0, 0}); // 8 bit RGBA, deflate, no filter, no interlace
+        endChunk(out, start);
+
+        start = out.size();
+        beginChunk(out, "IDAT");
+        out.insert(out.end(), {0x78, 0x01});
+
+        // The scanlines as one stream, cut into stored blocks wherever the size limit falls
+        std::uint32_t adlerA = 1, adlerB = 0;
+        std::size_t written = 0;
+        std::uint32_t row = 0;
+        std::size_t column = 0; // position within rowBytes
+        const auto* pixels = static_cast<const std::uint8_t*>(rgba->pixels);
+        while (written < rawSize)
+        {
+            const std::size_t block = std::min(STORED_BLOCK_MAX, rawSize - written);
+            const bool last = written + block == rawSize;
+            out.push_back(last ? 1 : 0);
+            out.push_back(static_cast<std::uint8_t>(block));
+            out.push_back(static_cast<std::uint8_t>(block >> 8));
+            out.push_back(static_cast<std::uint8_t>(~block));
+            out.push_back(static_cast<std::uint8_t>(~block >> 8));
+
+            std::size_t remaining = block;
+            while (remaining > 0)
+            {
+                const std::size_t base = out.size();
+                if (column == 0)
+                {
+                    out.push_back(0);
+                    ++column;
+                    --remaining;
+                }
+                const std::size_t take = std::min(remaining, rowBytes - column);
+                const std::uint8_t* src = pixels + static_cast<std::size_t>(row) * rgba->pitch + (column - 1);
+                out.insert(out.end(), src, src + take);
+                column += take;
+                remaining -= take;
+                if (column == rowBytes)
+                {
+                    column = 0;
+                    ++row;
+                }
+
+                adler32(adlerA, adlerB, out.data() + base, out.size() - base);
+            }
+            written += block;
+        }
+        putBE32(out, adlerB << 16 | adlerA);
+        endChunk(out, start);
+
+        start = out.size();
+        beginChunk(out, "IEND");
+        endChunk(out, start);
+    }
+}
+
+FrameExporter::FrameExporter(std::string target, const int width, const int height)
+    : m_target(std::move(target)), m_width(width), m_height(height)
+{
+}
+
+FrameExporter::~FrameExporter()
+{
+    finish();
+}
+
+bool FrameExporter::open()
+{
+    if (streaming())
+    {
+#if defined(_WIN32)
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        m_stream = stdout;
+    }
+    else
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(m_target, ec);
+        if (!std::filesystem::is_directory(m_target, ec))
+        {
+            SDL_Log("Export directory '%s' cannot be created", m_target.c_str());
+            return false;
+        }
+    }
+
+    m_writer = std::jthread([this] { run(); });
+    return true;
+}
+
+bool FrameExporter::submit(SDL_Surface* frame)
+{
+    std::unique_lock lock(m_mutex);
+    m_changed.wait(lock, [this] { return m_queue.size() < QUEUE_DEPTH || m_failed; });
+    if (m_failed || !m_writer.joinable())
+    {
+        SDL_DestroySurface(frame);
+        return false;
+    }
+    m_queue.push_back(frame);
+    m_changed.notify_all();
+    return true;
+}
+
+bool FrameExporter::finish()
+{
+    if (m_writer.joinable())
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_closing = true;
+        }
+        m_changed.notify_all();
+        m_writer.join();
+    }
+    if (m_stream) std::fflush(m_stream);
+
+    std::lock_guard lock(m_mutex);
+    for (SDL_Surface* frame : m_queue) SDL_DestroySurface(frame);
+    m_queue.clear();
+    return !m_failed;
+}
+
+void FrameExporter::run()
+{
+    for (std::size_t index = 0;; ++index)
+    {
+        SDL_Surface* frame;
+        {
+            std::unique_lock lock(m_mutex);
+            m_changed.wait(lock, [this] { return !m_queue.empty() || m_closing; });
+            if (m_queue.empty()) return;
+            frame = m_queue.front();
+            m_queue.pop_front();
+        }
+        m_changed.notify_all();
+
+        const bool ok = write(frame, index);
+        if (!ok)
+        {
+            std::lock_guard lock(m_mutex);
+            m_failed = true;
+            m_changed.notify_all();
+            return;
+        }
+    }
+}
+
+bool FrameExporter::write(SDL_Surface* frame, const std::size_t index)
+{
+    // Readback comes in the renderer's native layout; both outputs want RGBA bytes
+    SDL_Surface* rgba = frame;
+    if (frame && frame->format != SDL_PIXELFORMAT_RGBA32)
+    {
+        rgba = SDL_ConvertSurface(frame, SDL_PIXELFORMAT_RGBA32);
+        SDL_DestroySurface(frame);
+    }
+    if (!rgba || rgba->w != m_width || rgba->h != m_height)
+    {
+        SDL_Log("Export frame %zu has no pixels or the wrong size", index);
+        if (rgba) SDL_DestroySurface(rgba);
+        return false;
+    }
+
+    bool ok = true;
+    if (m_stream)
+    {
+        const auto* pixels = static_cast<const std::uint8_t*>(rgba->pixels);
+        const auto rowBytes = static_cast<std::size_t>(m_width) * 4;
+        for (int y = 0; y < m_height && ok; ++y)
+        {
+            ok = std::fwrite(pixels + static_cast<std::size_t>(y) * rgba->pitch, 1, rowBytes, m_stream) == rowBytes;
+        }
+        if (!ok) SDL_Log("Export stream closed at frame %zu", index);
+    }
+    else
+    {
+        encodePng(m_encoded, rgba);
+        const std::string path = (std::filesystem::path(m_target) / std::format("frame_{:05}.png", index)).string();
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        ok = file && std::fwrite(m_encoded.data(), 1, m_encoded.size(), file) == m_encoded.size();
+        if (file) ok = std::fclose(file) == 0 && ok;
+        if (!ok) SDL_Log("Failed to write %s", path.c_str());
+    }
+
+    SDL_DestroySurface(rgba);
+    return ok;
+}
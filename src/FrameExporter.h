@@ -0,0 +1,55 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writes rendered frames from a background thread, either as a numbered PNG sequence in a directory or as raw RGBA
+// on stdout for piping into ffmpeg ("-" as the target). Up to QUEUE_DEPTH frames wait for the writer, so reading
+// back frame N overlaps with encoding and writing frame N-1; submit() only blocks when the writer falls behind.
+class FrameExporter
+{
+public:
+    static constexpr std::size_t QUEUE_DEPTH = 2;
+
+    FrameExporter(std::string target, int width, int height);
+    ~FrameExporter();
+
+    FrameExporter(const FrameExporter&) = delete;
+    FrameExporter& operator=(const FrameExporter&) = delete;
+
+    // Prepares the target and starts the writer; false if the target cannot be written to
+    bool open();
+
+    // Takes ownership of a frame from SDL_RenderReadPixels; false once writing has failed
+    bool submit(SDL_Surface* frame);
+
+    // Writes everything still queued and stops the writer; false if any frame was lost
+    bool finish();
+
+    [[nodiscard]] bool streaming() const { return m_target == "-"; }
+
+private:
+    void run();
+    bool write(SDL_Surface* frame, std::size_t index);
+
+    std::string m_target;
+    int m_width;
+    int m_height;
+    std::FILE* m_stream = nullptr;
+    std::vector<std::uint8_t> m_encoded; // writer thread only, reused between frames
+
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::deque<SDL_Surface*> m_queue;
+    bool m_closing = false;
+    bool m_failed = false;
+    std::jthread m_writer;
+};
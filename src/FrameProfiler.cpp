@@ -0,0 +1,131 @@
+#include "FrameProfiler.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+    constexpr const char* FRAME_ZONE = "frame";
+}
+
+FrameProfiler::Zone::Zone(FrameProfiler& profiler, const char* name)
+    : m_profiler(profiler), m_index(profiler.zoneIndex(name)), m_start(Clock::now())
+{
+}
+
+FrameProfiler::Zone::~Zone()
+{
+    m_profiler.record(m_index, m_start, Clock::now());
+}
+
+std::size_t FrameProfiler::zoneIndex(const char* name)
+{
+    for (std::size_t i = 0; i < m_zones.size(); ++i)
+    {
+        if (m_zones[i].name == name || std::strcmp(m_zones[i].name, name) == 0) return i;
+    }
+    if (m_zones.size() == MAX_ZONES) return MAX_ZONES;
+    m_zones.push_back({name});
+    return m_zones.size() - 1;
+}
+
+void FrameProfiler::record(const std::size_t index, const Clock::time_point start, const Clock::time_point end)
+{
+    if (index >= m_zones.size()) return;
+    m_zones[index].current += std::chrono::duration<double, std::milli>(end - start).count();
+
+    if (m_tracing)
+    {
+        using us = std::chrono::microseconds;
+        m_trace.push_back({
+            m_zones[index].name,
+            std::chrono::duration_cast<us>(start - m_traceStart).count(),
+            std::chrono::duration_cast<us>(end - start).count()
+        });
+        if (m_trace.size() >= MAX_TRACE_EVENTS) m_tracing = false;
+    }
+}
+
+void FrameProfiler::beginFrame()
+{
+    if (m_zones.empty()) m_zones.push_back({FRAME_ZONE});
+    for (auto& zone : m_zones) zone.current = 0.0;
+    m_drawCalls = 0;
+    m_vertices = 0;
+    m_frameStart = Clock::now();
+}
+
+void FrameProfiler::endFrame()
+{
+    record(0, m_frameStart, Clock::now());
+
+    const std::size_t slot = m_frame % HISTORY_FRAMES;
+    for (auto& zone : m_zones) zone.ms[slot] = static_cast<float>(zone.current);
+    m_drawCallHistory[slot] = static_cast<float>(m_drawCalls);
+    m_vertexHistory[slot] = static_cast<float>(m_vertices);
+    ++m_frame;
+}
+
+void FrameProfiler::countDraw(const std::size_t vertices)
+{
+    ++m_drawCalls;
+    m_vertices += vertices;
+}
+
+double FrameProfiler::mean(const std::array<float, HISTORY_FRAMES>& history) const
+{
+    const std::size_t frames = std::min(m_frame, HISTORY_FRAMES);
+    if (frames == 0) return 0.0;
+    double sum = 0.0;
+    for (std::size_t i = 0; i < frames; ++i) sum += history[i];
+    return sum / static_cast<double>(frames);
+}
+
+std::vector<FrameProfiler::ZoneStats> FrameProfiler::stats() const
+{
+    const std::size_t frames = std::min(m_frame, HISTORY_FRAMES);
+    std::vector<ZoneStats> out;
+    out.reserve(m_zones.size());
+
+    std::array<float, HISTORY_FRAMES> sorted{};
+    for (const auto& zone : m_zones)
+    {
+        if (frames == 0)
+        {
+            out.push_back({zone.name, 0.0, 0.0});
+            continue;
+        }
+        // A zone first seen late still has zeros for the frames before, which is what it cost then
+        std::copy_n(zone.ms.begin(), frames, sorted.begin());
+        const std::size_t rank = (frames * 99 + 99) / 100; // nearest-rank p99
+        std::nth_element(sorted.begin(), sorted.begin() + (rank - 1), sorted.begin() + frames);
+        out.push_back({zone.name, mean(zone.ms), sorted[rank - 1]});
+    }
+    return out;
+}
+
+void FrameProfiler::startTrace()
+{
+    m_trace.clear();
+    m_traceStart = Clock::now();
+    m_tracing = true;
+}
+
+bool FrameProfiler::stopTrace(const std::string& path)
+{
+    m_tracing = false;
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) return false;
+
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    for (std::size_t i = 0; i < m_trace.size(); ++i)
+    {
+        const TraceEvent& event = m_trace[i];
+        file << (i ? ",\n" : "") << "{\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1"
+            << ", \"ts\": " << event.startUs << ", \"dur\": " << event.durationUs << "}";
+    }
+    file << "\n]}\n";
+    m_trace.clear();
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Per-frame timing of named stages plus draw call and vertex counters. Every frame's durations go into a ring
+// buffer of HISTORY_FRAMES entries per zone, from which the overlay reads rolling means and p99s. While a trace is
+// recording each zone is also kept as a Chrome trace event (chrome://tracing, Perfetto).
+class FrameProfiler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t HISTORY_FRAMES = 240;
+    static constexpr std::size_t MAX_ZONES = 16;
+    // Trace recording stops by itself after this many events
+    static constexpr std::size_t MAX_TRACE_EVENTS = 1 << 20;
+
+    // Times its scope into the named zone; `name` must outlive the profiler (string literals)
+    class Zone
+    {
+    public:
+        Zone(FrameProfiler& profiler, const char* name);
+        ~Zone();
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+    private:
+        FrameProfiler& m_profiler;
+        std::size_t m_index;
+        Clock::time_point m_start;
+    };
+
+    struct ZoneStats
+    {
+        std::string_view name;
+        double meanMs;
+        double p99Ms;
+    };
+
+    void beginFrame();
+    void endFrame();
+
+    void countDraw(std::size_t vertices);
+
+    // Zones in first-use order, the whole frame first; statistics over the recorded history
+    [[nodiscard]] std::vector<ZoneStats> stats() const;
+    [[nodiscard]] double meanDrawCalls() const { return mean(m_drawCallHistory); }
+    [[nodiscard]] double meanVertices() const { return mean(m_vertexHistory); }
+
+    void startTrace();
+    // Writes the recorded events as Chrome trace JSON; returns false if the file cannot be written
+    bool stopTrace(const std::string& path);
+    [[nodiscard]] bool tracing() const { return m_tracing; }
+
+private:
+    struct ZoneHistory
+    {
+        const char* name = nullptr;
+        std::array<float, HISTORY_FRAMES> ms{};
+        double current = 0.0; // accumulated this frame, a zone may be entered more than once
+    };
+
+    struct TraceEvent
+    {
+        const char* name;
+        std::int64_t startUs;
+        std::int64_t durationUs;
+    };
+
+    [[nodiscard]] std::size_t zoneIndex(const char* name);
+    void record(std::size_t index, Clock::time_point start, Clock::time_point end);
+    [[nodiscard]] double mean(const std::array<float, HISTORY_FRAMES>& history) const;
+
+    std::vector<ZoneHistory> m_zones;
+    std::array<float, HISTORY_FRAMES> m_drawCallHistory{};
+    std::array<float, HISTORY_FRAMES> m_vertexHistory{};
+    std::size_t m_frame = 0; // frames completed, the ring position is m_frame % HISTORY_FRAMES
+    Clock::time_point m_frameStart{};
+    std::size_t m_drawCalls = 0;
+    std::size_t m_vertices = 0;
+
+    bool m_tracing = false;
+    Clock::time_point m_traceStart{};
+    std::vector<TraceEvent> m_trace;
+};
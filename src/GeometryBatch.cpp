@@ -0,0 +1,136 @@
+#include "GeometryBatch.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+using geometry::Vec2f;
+
+void GeometryBatch::begin(const float viewportWidth, const float viewportHeight)
+{
+    m_vertices.clear();
+    m_indices.clear();
+    m_viewportWidth = viewportWidth;
+    m_viewportHeight = viewportHeight;
+}
+
+const std::vector<Vec2f>& GeometryBatch::unitCircle(const int segments)
+{
+    if (m_unitCircles.size() <= static_cast<std::size_t>(segments))
+    {
+        m_unitCircles.resize(segments + 1);
+    }
+
+    auto& points = m_unitCircles[segments];
+    if (points.empty()) points = makeUnitCircle(segments);
+    return points;
+}
+
+std::vector<Vec2f> GeometryBatch::makeUnitCircle(const int segments)
+{
+    std::vector<Vec2f> points(segments);
+    for (int i = 0; i < segments; ++i)
+    {
+        const float theta = 2.0f * std::numbers::pi_v<float> * static_cast<float>(i) / static_cast<float>(segments);
+        points[i] = {std::cos(theta), std::sin(theta)};
+    }
+    return points;
+}
+
+bool GeometryBatch::isOffscreen(const Vec2f center, const float extent, const float width, const float height)
+{
+    return center.x + extent < 0.0f || center.y + extent < 0.0f || center.x - extent > width ||
+        center.y - extent > height;
+}
+
+bool GeometryBatch::isOffscreen(const Vec2f center, const float extent) const
+{
+    return isOffscreen(center, extent, m_viewportWidth, m_viewportHeight);
+}
+
+void GeometryBatch::addCircle(const Vec2f center, const float radius, const int segments, const float thickness,
+                              const SDL_FColor color)
+{
+    const float half = thickness * 0.5f;
+    if (segments < 3 || isOffscreen(center, radius + half)) return;
+
+    const auto& unit = unitCircle(segments);
+    const auto n = static_cast<std::size_t>(segments);
+    reserve(n * RING_VERTICES_PER_SEGMENT, n * RING_INDICES_PER_SEGMENT)
+        .writeRing(center, unit, std::max(radius - half, 0.0f), radius + half, color);
+}
+
+void GeometryBatch::addLine(const Vec2f a, const Vec2f b, const float thickness, const SDL_FColor color)
+{
+    const float half = thickness * 0.5f;
+    const Vec2f d = b - a;
+    const float len = d.length();
+    if (len <= 0.0f) return;
+
+    const Vec2f mid = (a + b) * 0.5f;
+    if (isOffscreen(mid, len * 0.5f + half)) return;
+
+    reserve(QUAD_VERTICES, QUAD_INDICES).writeQuad(a, b, Vec2f{-d.y, d.x} * (half / len), color);
+}
+
+void GeometryBatch::addPolyline(const std::span<const Vec2f> points, const float thickness, const SDL_FColor color)
+{
+    for (std::size_t i = 1; i < points.size(); ++i) addLine(points[i - 1], points[i], thickness, color);
+}
+
+void GeometryBatch::append(const GeometryBatch& other)
+{
+    const int base = static_cast<int>(m_vertices.size());
+    m_vertices.insert(m_vertices.end(), other.m_vertices.begin(), other.m_vertices.end());
+    m_indices.reserve(m_indices.size() + other.m_indices.size());
+    for (const int index : other.m_indices) m_indices.push_back(base + index);
+}
+
+GeometryBatch::Reservation GeometryBatch::reserve(const std::size_t vertices, const std::size_t indices)
+{
+    const std::size_t firstVertex = m_vertices.size();
+    const std::size_t firstIndex = m_indices.size();
+    m_vertices.resize(firstVertex + vertices);
+    m_indices.resize(firstIndex + indices);
+    return {m_vertices.data() + firstVertex, m_indices.data() + firstIndex, static_cast<int>(firstVertex)};
+}
+
+void GeometryBatch::Reservation::writeRing(const Vec2f center, const std::span<const Vec2f> unit, const float inner,
+                                           const float outer, const SDL_FColor color)
+{
+    // Two vertices (inner, outer) per point, two triangles per segment wrapping back to the first point
+    for (const Vec2f& u : unit)
+    {
+        const Vec2f a = center + u * inner;
+        const Vec2f b = center + u * outer;
+        *vertices++ = {{a.x, a.y}, color, {0.0f, 0.0f}};
+        *vertices++ = {{b.x, b.y}, color, {0.0f, 0.0f}};
+    }
+
+    const int segments = static_cast<int>(unit.size());
+    for (int i = 0; i < segments; ++i)
+    {
+        const int i0 = base + 2 * i;
+        const int i1 = base + 2 * ((i + 1) % segments);
+        for (const int k : {i0, i0 + 1, i1 + 1, i0, i1 + 1, i1}) *indices++ = k;
+    }
+    base += 2 * segments;
+}
+
+void GeometryBatch::Reservation::writeQuad(const Vec2f a, const Vec2f b, const Vec2f offset, const SDL_FColor color)
+{
+    for (const Vec2f& p : {a + offset, a - offset, b - offset, b + offset})
+    {
+        *vertices++ = {{p.x, p.y}, color, {0.0f, 0.0f}};
+    }
+    for (const int k : {base, base + 1, base + 2, base, base + 2, base + 3}) *indices++ = k;
+    base += 4;
+}
+
+void GeometryBatch::draw(SDL_Renderer* renderer) const
+{
+    if (m_indices.empty()) return;
+
+    SDL_RenderGeometry(renderer, nullptr,
+                       m_vertices.data(), static_cast<int>(m_vertices.size()),
+                       m_indices.data(), static_cast<int>(m_indices.size()));
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "Vec2.h"
+
+// Collects untextured triangles for one frame and submits them with a single SDL_RenderGeometry call
+class GeometryBatch
+{
+public:
+    GeometryBatch() = default;
+
+    // Drops the previous frame's geometry and sets the screen area used for culling
+    void begin(float viewportWidth, float viewportHeight);
+
+    // Circle outline as a ring of thin quads, built from a cached unit circle with `segments` points.
+    // Rings entirely outside the viewport are skipped.
+    void addCircle(geometry::Vec2f center, float radius, int segments, float thickness, SDL_FColor color);
+
+    // Line segment as a quad of the given thickness; degenerate or off-screen segments are skipped
+    void addLine(geometry::Vec2f a, geometry::Vec2f b, float thickness, SDL_FColor color);
+
+    // Open polyline through `points`, one addLine quad per segment
+    void addPolyline(std::span<const geometry::Vec2f> points, float thickness, SDL_FColor color);
+
+    // Copies another batch's geometry after this one's, so separately built batches go out in one draw call
+    void append(const GeometryBatch& other);
+
+    // Sizes of the shapes addCircle and addLine build, for callers sizing a reservation
+    static constexpr std::size_t RING_VERTICES_PER_SEGMENT = 2;
+    static constexpr std::size_t RING_INDICES_PER_SEGMENT = 6;
+    static constexpr std::size_t QUAD_VERTICES = 4;
+    static constexpr std::size_t QUAD_INDICES = 6;
+
+    // Room for geometry the caller writes itself, possibly from several threads. Indices refer to the whole batch,
+    // the reserved vertices start at `base`.
+    struct Reservation
+    {
+        SDL_Vertex* vertices;
+        int* indices;
+        int base;
+
+        // The shapes of addCircle and addLine, written without culling; each advances the reservation past itself.
+        // A ring goes around `unit` (see makeUnitCircle), the quad's corners are a +- offset and b -+ offset.
+        void writeRing(geometry::Vec2f center, std::span<const geometry::Vec2f> unit, float inner, float outer,
+                       SDL_FColor color);
+        void writeQuad(geometry::Vec2f a, geometry::Vec2f b, geometry::Vec2f offset, SDL_FColor color);
+    };
+    [[nodiscard]] Reservation reserve(std::size_t vertices, std::size_t indices);
+
+    // `segments` points evenly spaced on the unit circle, starting at (1, 0)
+    [[nodiscard]] static std::vector<geometry::Vec2f> makeUnitCircle(int segments);
+    // True when the square of half size `extent` around `center` misses a width x height viewport
+    [[nodiscard]] static bool isOffscreen(geometry::Vec2f center, float extent, float width, float height);
+
+    void draw(SDL_Renderer* renderer) const;
+
+    [[nodiscard]] std::size_t vertexCount() const { return m_vertices.size(); }
+
+private:
+    [[nodiscard]] const std::vector<geometry::Vec2f>& unitCircle(int segments);
+    [[nodiscard]] bool isOffscreen(geometry::Vec2f center, float extent) const;
+
+    std::vector<SDL_Vertex> m_vertices;
+    std::vector<int> m_indices;
+
+    // m_unitCircles[n] holds n points on the unit circle, built the first time n is requested
+    std::vector<std::vector<geometry::Vec2f>> m_unitCircles;
+
+    float m_viewportWidth = 0.0f;
+    float m_viewportHeight = 0.0f;
+};
@@ -0,0 +1,131 @@
+#include "LiveDrawing.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#include "svg.h"
+
+using geometry::Vec2f;
+
+LiveDrawing::LiveDrawing()
+    : m_rotation(WINDOW), m_ring(WINDOW), m_bins(WINDOW), m_window(WINDOW), m_coefficients(WINDOW)
+{
+    for (std::size_t k = 0; k < WINDOW; ++k)
+    {
+        const double phase = 2.0 * std::numbers::pi * static_cast<double>(k) / static_cast<double>(WINDOW);
+        m_rotation[k] = {static_cast<float>(std::cos(phase)), static_cast<float>(std::sin(phase))};
+    }
+}
+
+void LiveDrawing::begin(const Vec2f point, const float spacing)
+{
+    std::ranges::fill(m_ring, point);
+    m_head = 0;
+    // The DFT of a constant window is all DC
+    std::ranges::fill(m_bins, Vec2f{0.0f, 0.0f});
+    m_bins[0] = point * static_cast<float>(WINDOW);
+
+    m_strokeSamples = 1;
+    m_sinceTransform = 0;
+    m_last = point;
+    m_spacing = std::max(spacing, 1e-6f);
+    m_carry = 0.0f;
+    m_active = true;
+    m_changed = true;
+}
+
+void LiveDrawing::extend(const Vec2f point)
+{
+    if (!m_active) return;
+
+    const Vec2f d = point - m_last;
+    const float length = d.length();
+    if (length <= 0.0f) return;
+
+    // Samples fall every m_spacing along the stroke, the first one m_spacing - m_carry into this segment
+    const auto count = static_cast<std::size_t>((m_carry + length) / m_spacing);
+    const float step = std::max(m_spacing, (m_carry + length) / static_cast<float>(MAX_SAMPLES_PER_EXTEND));
+    float s = step - m_carry;
+    std::size_t pushed = 0;
+    for (; s <= length && pushed < std::min(count, MAX_SAMPLES_PER_EXTEND); s += step, ++pushed)
+    {
+        push(m_last + d * (s / length));
+    }
+    m_carry = length - (s - step);
+    m_last = point;
+}
+
+void LiveDrawing::finish()
+{
+    if (!m_active) return;
+    m_active = false;
+
+    const std::size_t drawn = std::min(m_strokeSamples, WINDOW);
+    if (drawn < 2) return;
+
+    // Newest `drawn` samples in stroke order, then spread evenly over the window by arc length
+    svg::PathPoly poly;
+    poly.pts.reserve(drawn + 1);
+    for (std::size_t i = WINDOW - drawn; i < WINDOW; ++i) poly.pts.push_back(m_ring[(m_head + i) % WINDOW]);
+    if ((m_last - poly.pts.back()).length_sq() > 0.0f) poly.pts.push_back(m_last);
+    poly.cum.resize(poly.pts.size());
+    poly.cum[0] = 0.0f;
+    for (std::size_t i = 1; i < poly.pts.size(); ++i)
+    {
+        poly.cum[i] = poly.cum[i - 1] + (poly.pts[i] - poly.pts[i - 1]).length();
+    }
+    poly.length = poly.cum.back();
+    if (poly.length <= 0.0f) return;
+
+    svg::FlattenedPath stroke;
+    stroke.length = poly.length;
+    stroke.paths.push_back(std::move(poly));
+    m_ring = svg::resample(stroke, WINDOW);
+    m_head = 0;
+    retransform();
+    m_changed = true;
+}
+
+bool LiveDrawing::takeChanged()
+{
+    const bool changed = m_changed;
+    m_changed = false;
+    return changed;
+}
+
+std::span<const Vec2f> LiveDrawing::coefficients()
+{
+    const float invN = 1.0f / static_cast<float>(WINDOW);
+    for (std::size_t k = 0; k < WINDOW; ++k) m_coefficients[k] = m_bins[k] * invN;
+    return m_coefficients;
+}
+
+std::span<const Vec2f> LiveDrawing::points()
+{
+    for (std::size_t i = 0; i < WINDOW; ++i) m_window[i] = m_ring[(m_head + i) % WINDOW];
+    return m_window;
+}
+
+void LiveDrawing::push(const Vec2f sample)
+{
+    // Window x[0..N) becomes x[1..N] + sample: X'_k = (X_k - x_0 + sample) * e^{2 pi i k / N}
+    const Vec2f delta = sample - m_ring[m_head];
+    m_ring[m_head] = sample;
+    m_head = (m_head + 1) % WINDOW;
+    for (std::size_t k = 0; k < WINDOW; ++k)
+    {
+        const Vec2f b = m_bins[k] + delta;
+        const Vec2f r = m_rotation[k];
+        m_bins[k] = {b.x * r.x - b.y * r.y, b.x * r.y + b.y * r.x};
+    }
+
+    ++m_strokeSamples;
+    if (++m_sinceTransform >= WINDOW) retransform();
+    m_changed = true;
+}
+
+void LiveDrawing::retransform()
+{
+    fft::plan(WINDOW).execute(points(), m_bins);
+    m_sinceTransform = 0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "Vec2.h"
+#include "fft.h"
+
+// A stroke drawn with the mouse, kept as its last WINDOW samples spaced evenly along the stroke, together with the
+// DFT of that window. Each new sample replaces the oldest one, which a sliding DFT folds into every bin as the
+// difference of the two followed by a one-sample rotation: O(WINDOW) per sample instead of a transform plus sort
+// per input event. Rounding drift is cleared by a full transform with a cached plan once per WINDOW samples.
+// A stroke starts out as its first point repeated over the window; finish() spreads the drawn part evenly over the
+// whole window.
+class LiveDrawing
+{
+public:
+    // Samples in the window, a power of two so the plan is radix 2
+    static constexpr std::size_t WINDOW = 1024;
+    // Samples one input event may add; a longer jump is sampled more coarsely
+    static constexpr std::size_t MAX_SAMPLES_PER_EXTEND = WINDOW / 4;
+
+    LiveDrawing();
+
+    // Starts a new stroke at `point`, sampled every `spacing` world units
+    void begin(geometry::Vec2f point, float spacing);
+    // Continues the stroke in a straight line to `point`
+    void extend(geometry::Vec2f point);
+    // Ends the stroke and resamples what was drawn over the whole window
+    void finish();
+
+    [[nodiscard]] bool active() const { return m_active; }
+    // The window changed since the last takeChanged()
+    [[nodiscard]] bool changed() const { return m_changed; }
+    bool takeChanged();
+
+    // DFT bins of the window divided by WINDOW, as FourierCircles::calculateCoefficients would compute them
+    [[nodiscard]] std::span<const geometry::Vec2f> coefficients();
+    // The window, oldest sample first
+    [[nodiscard]] std::span<const geometry::Vec2f> points();
+
+private:
+    void push(geometry::Vec2f sample);
+    void retransform();
+
+    std::vector<geometry::Vec2f> m_rotation; // e^{2 pi i k / WINDOW}, shifts bin k by one sample
+
+    std::vector<geometry::Vec2f> m_ring; // m_ring[m_head] is the oldest sample
+    std::size_t m_head = 0;
+    std::vector<geometry::Vec2f> m_bins; // unnormalized DFT of the window
+
+    std::size_t m_strokeSamples = 0; // samples pushed since begin(), the window holds min(this, WINDOW) of them
+    std::size_t m_sinceTransform = 0;
+    geometry::Vec2f m_last{}; // last input point
+    float m_spacing = 1.0f;
+    float m_carry = 0.0f; // stroke length since the last sample
+    bool m_active = false;
+    bool m_changed = false;
+
+    std::vector<geometry::Vec2f> m_window; // scratch: unrolled window
+    std::vector<geometry::Vec2f> m_coefficients;
+};
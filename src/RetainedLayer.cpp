@@ -0,0 +1,79 @@
+#include "RetainedLayer.h"
+#include <algorithm>
+#include <cmath>
+
+using geometry::Vec2f;
+
+RetainedLayer::~RetainedLayer()
+{
+    if (m_texture) SDL_DestroyTexture(m_texture);
+}
+
+bool RetainedLayer::prepare(SDL_Renderer* renderer, const int viewportWidth, const int viewportHeight,
+                            const float zoom, const Vec2f offset, const std::uint64_t version)
+{
+    if (m_texture && viewportWidth == m_viewportWidth && viewportHeight == m_viewportHeight && zoom == m_zoom &&
+        version == m_version)
+    {
+        const Vec2f shift = offset - m_anchor;
+        if (std::abs(shift.x) <= m_margin && std::abs(shift.y) <= m_margin) return false;
+    }
+
+    if (!m_texture || viewportWidth != m_viewportWidth || viewportHeight != m_viewportHeight)
+    {
+        if (m_texture) SDL_DestroyTexture(m_texture);
+        m_viewportWidth = viewportWidth;
+        m_viewportHeight = viewportHeight;
+        m_margin = std::ceil(static_cast<float>(std::max(viewportWidth, viewportHeight)) * MARGIN);
+        m_width = viewportWidth + 2 * static_cast<int>(m_margin);
+        m_height = viewportHeight + 2 * static_cast<int>(m_margin);
+
+        m_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, m_width, m_height);
+        if (!m_texture)
+        {
+            SDL_Log("Failed to create %dx%d layer: %s", m_width, m_height, SDL_GetError());
+            return false;
+        }
+        SDL_SetTextureBlendMode(m_texture, SDL_BLENDMODE_BLEND_PREMULTIPLIED);
+        // Shifts are rounded to whole pixels, so sampling never has to blend neighbors
+        SDL_SetTextureScaleMode(m_texture, SDL_SCALEMODE_NEAREST);
+    }
+
+    m_zoom = zoom;
+    m_version = version;
+    m_anchor = {std::round(offset.x), std::round(offset.y)};
+
+    bind(renderer);
+    clear(renderer);
+    unbind(renderer);
+    return true;
+}
+
+void RetainedLayer::bind(SDL_Renderer* renderer)
+{
+    m_previousTarget = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, m_texture);
+}
+
+void RetainedLayer::unbind(SDL_Renderer* renderer)
+{
+    SDL_SetRenderTarget(renderer, m_previousTarget);
+    m_previousTarget = nullptr;
+}
+
+void RetainedLayer::clear(SDL_Renderer* renderer)
+{
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+}
+
+void RetainedLayer::composite(SDL_Renderer* renderer, const Vec2f offset) const
+{
+    if (!m_texture) return;
+    const Vec2f shift = offset - m_anchor;
+    const SDL_FRect destination = {
+        std::round(shift.x) - m_margin, std::round(shift.y) - m_margin,
+        static_cast<float>(m_width), static_cast<float>(m_height)
+    };
+    SDL_RenderTexture(renderer, m_texture, nullptr, &destination);
+}
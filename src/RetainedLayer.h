@@ -0,0 +1,58 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <cstdint>
+
+#include "Vec2.h"
+
+// Offscreen render target that keeps what was drawn into it across frames. It is MARGIN larger than the viewport
+// on every side, so as long as the camera only pans by less than that the layer is composited shifted instead of
+// redrawn. A new viewport size, zoom or content version, or a pan past the margin, invalidates it. Contents are
+// kept premultiplied: drawing with SDL_BLENDMODE_BLEND into the cleared layer yields premultiplied color, which
+// the layer is composited with.
+class RetainedLayer
+{
+public:
+    // Fraction of the larger viewport dimension added on each side
+    static constexpr float MARGIN = 0.25f;
+
+    RetainedLayer() = default;
+    ~RetainedLayer();
+
+    RetainedLayer(const RetainedLayer&) = delete;
+    RetainedLayer& operator=(const RetainedLayer&) = delete;
+
+    // Checks the layer against this frame's view; when it no longer matches it is cleared, anchored at `offset`
+    // and true is returned so the caller redraws. False on a texture failure too, with valid() false.
+    bool prepare(SDL_Renderer* renderer, int viewportWidth, int viewportHeight, float zoom, geometry::Vec2f offset,
+                 std::uint64_t version);
+
+    [[nodiscard]] bool valid() const { return m_texture != nullptr; }
+    // Forces a redraw at the next prepare(), e.g. after the renderer lost its render targets
+    void invalidate() { m_zoom = 0.0f; }
+
+    // Makes the layer the render target until unbind(), which restores the previous one. While bound, world p maps
+    // to p * zoom + drawOffset() and the drawable area is width() x height().
+    void bind(SDL_Renderer* renderer);
+    void unbind(SDL_Renderer* renderer);
+    void clear(SDL_Renderer* renderer);
+
+    [[nodiscard]] geometry::Vec2f drawOffset() const { return m_anchor + geometry::Vec2f{m_margin, m_margin}; }
+    [[nodiscard]] float width() const { return static_cast<float>(m_width); }
+    [[nodiscard]] float height() const { return static_cast<float>(m_height); }
+
+    // Draws the layer into the current target for a camera at `offset`
+    void composite(SDL_Renderer* renderer, geometry::Vec2f offset) const;
+
+private:
+    SDL_Texture* m_texture = nullptr;
+    SDL_Texture* m_previousTarget = nullptr;
+    int m_viewportWidth = 0;
+    int m_viewportHeight = 0;
+    int m_width = 0;
+    int m_height = 0;
+    float m_margin = 0.0f;
+    float m_zoom = 0.0f;
+    geometry::Vec2f m_anchor{}; // camera offset the contents were drawn for
+    std::uint64_t m_version = 0;
+};
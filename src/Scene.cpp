@@ -0,0 +1,97 @@
+#include "Scene.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <numeric>
+
+using geometry::Vec2f;
+
+void Scene::add(FourierCircles circles, const Vec2f position, const float scale, const float phase)
+{
+    // LOD picks prefixes of the magnitude order at any zoom, so sort it all once up front
+    circles.orderCoefficients(circles.size());
+    const auto magnitudes = circles.getSortedMagnitudes();
+    const float reach = std::accumulate(magnitudes.begin(), magnitudes.end(), 0.0f);
+
+    m_drawings.push_back({std::move(circles), {}, {}, position, scale, phase - std::floor(phase), reach});
+}
+
+void Scene::clear()
+{
+    m_drawings.clear();
+    m_merged.begin(0.0f, 0.0f);
+    m_visible = 0;
+}
+
+void Scene::update(ThreadPool& pool, const float periodT, const float step, const int steps, const float zoom,
+                   const Vec2f offset, const float viewportWidth, const float viewportHeight)
+{
+    pool.parallelFor(m_drawings.size(), [&](const std::size_t i)
+    {
+        updateDrawing(m_drawings[i], periodT, step, steps, zoom, offset, viewportWidth, viewportHeight);
+    });
+
+    m_merged.begin(viewportWidth, viewportHeight);
+    m_visible = 0;
+    for (const Drawing& drawing : m_drawings)
+    {
+        if (!drawing.visible) continue;
+        ++m_visible;
+        m_merged.append(drawing.batch);
+    }
+}
+
+void Scene::updateDrawing(Drawing& drawing, const float periodT, const float step, const int steps, const float zoom,
+                          const Vec2f offset, const float viewportWidth, const float viewportHeight) const
+{
+    const float pixelScale = zoom * drawing.scale;
+    const Vec2f origin = drawing.position * zoom + offset;
+    const float reach = drawing.reach * pixelScale +
+        std::max({m_style.contourWidth, m_style.epicycles.circleWidth, m_style.epicycles.armWidth});
+
+    drawing.batch.begin(viewportWidth, viewportHeight);
+    drawing.visible = origin.x + reach >= 0.0f && origin.y + reach >= 0.0f &&
+        origin.x - reach <= viewportWidth && origin.y - reach <= viewportHeight;
+    if (!drawing.visible) return;
+
+    const auto magnitudes = drawing.circles.getSortedMagnitudes();
+    const float threshold = LOD_MIN_RADIUS_PIXELS / pixelScale;
+    const auto needed = static_cast<std::size_t>(
+        std::partition_point(magnitudes.begin(), magnitudes.end(), [&](const float m) { return m >= threshold; }) -
+        magnitudes.begin());
+    if (needed == 0) return;
+
+    // Rounded up to a power of two so zooming only rebuilds the contour at a few thresholds
+    const std::size_t count = std::min(std::bit_ceil(needed), drawing.circles.size());
+    if (count != drawing.contourCount)
+    {
+        drawing.contour.build(drawing.circles, count,
+                              std::clamp(count * CONTOUR_SAMPLES_PER_VECTOR, CONTOUR_SAMPLES_MIN, CONTOUR_SAMPLES_MAX));
+        drawing.contourCount = count;
+    }
+
+    float t = periodT + drawing.phase;
+    if (t >= 1.0f) t -= 1.0f;
+    drawing.circles.stepVectors(t, step, steps, count);
+
+    drawing.contour.tessellate(drawing.circles, pixelScale, origin, viewportWidth, viewportHeight);
+    const auto points = drawing.contour.points();
+    for (const auto& [first, length] : drawing.contour.runs())
+    {
+        drawing.batch.addPolyline(points.subspan(first, length), m_style.contourWidth, m_style.contour);
+    }
+
+    const auto& vectors = drawing.circles.getVectors();
+    Vec2f prev = {0.0f, 0.0f};
+    for (std::size_t i = 0; i < vectors.size(); ++i)
+    {
+        const Vec2f center = origin + prev * pixelScale;
+        prev += vectors[i];
+        const Vec2f end = origin + prev * pixelScale;
+
+        const EpicycleMesh::Shape shape = m_epicycles.shape(center, vectors[i], pixelScale, viewportWidth,
+                                                            viewportHeight);
+        GeometryBatch::Reservation out = drawing.batch.reserve(shape.vertices(), shape.indices());
+        m_epicycles.write(out, shape, center, end, vectors[i], pixelScale, i);
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "ContourCache.h"
+#include "EpicycleMesh.h"
+#include "FourierCircles.h"
+#include "GeometryBatch.h"
+#include "ThreadPool.h"
+#include "Vec2.h"
+
+// Many independently animated drawings shown at once, e.g. a gallery wall. Each frame the drawings are updated in
+// parallel on a ThreadPool: a drawing whose bounding disk is off-screen is skipped entirely, and a visible one only
+// evaluates the vectors that are at least LOD_MIN_RADIUS_PIXELS long on screen (the coefficients are in descending
+// magnitude order, so that is a prefix). Every drawing fills its own GeometryBatch, and the batches are merged into
+// one so the whole scene is a single draw call.
+class Scene
+{
+public:
+    struct Style
+    {
+        SDL_FColor contour;
+        float contourWidth;
+        EpicycleMesh::Style epicycles; // of every drawing, meshed the same way as the main view's
+    };
+
+    // Vectors shorter than this on screen are left out of a drawing
+    static constexpr float LOD_MIN_RADIUS_PIXELS = 0.5f;
+    static constexpr std::size_t CONTOUR_SAMPLES_MIN = 512;
+    static constexpr std::size_t CONTOUR_SAMPLES_MAX = 16384;
+    static constexpr std::size_t CONTOUR_SAMPLES_PER_VECTOR = 4;
+
+    explicit Scene(const Style& style) : m_style(style), m_epicycles(style.epicycles) {}
+
+    // Adds a drawing whose local point p appears at world position + p * scale, running `phase` periods ahead
+    void add(FourierCircles circles, geometry::Vec2f position, float scale, float phase);
+    void clear();
+
+    [[nodiscard]] std::size_t size() const { return m_drawings.size(); }
+    [[nodiscard]] bool empty() const { return m_drawings.empty(); }
+    // Drawings inside the viewport at the last update()
+    [[nodiscard]] std::size_t visibleCount() const { return m_visible; }
+
+    // Advances every visible drawing to periodT (see FourierCircles::stepVectors for step and steps) and builds the
+    // frame's geometry for the camera mapping world p to p * zoom + offset
+    void update(ThreadPool& pool, float periodT, float step, int steps, float zoom, geometry::Vec2f offset,
+                float viewportWidth, float viewportHeight);
+
+    void draw(SDL_Renderer* renderer) const { m_merged.draw(renderer); }
+    [[nodiscard]] std::size_t vertexCount() const { return m_merged.vertexCount(); }
+
+private:
+    struct Drawing
+    {
+        FourierCircles circles;
+        ContourCache contour;
+        GeometryBatch batch;
+        geometry::Vec2f position;
+        float scale;
+        float phase;
+        float reach; // sum of all magnitudes, every vector tip lies within this distance of the local origin
+        std::size_t contourCount = 0; // vectors the contour was built for
+        bool visible = false;
+    };
+
+    void updateDrawing(Drawing& drawing, float periodT, float step, int steps, float zoom, geometry::Vec2f offset,
+                       float viewportWidth, float viewportHeight) const;
+
+    Style m_style;
+    EpicycleMesh m_epicycles; // only its per-vector steps are used, which are safe to run concurrently
+    std::vector<Drawing> m_drawings;
+    GeometryBatch m_merged;
+    std::size_t m_visible = 0;
+};
@@ -0,0 +1,239 @@
+#include "SvgLoader.h"
+
+#include <SDL3/SDL.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+namespace
+{
+    bool readFile(const std::string& path, std::string& out)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+        std::ostringstream ss;
+        ss << file.rdbuf();
+        out = std::move(ss).str();
+        return true;
+    }
+}
+
+SvgLoader::SvgLoader(const std::span<char> fallbackSvg, const std::span<const std::byte> fallbackSnapshot,
+                     const float offsetX, const float scale)
+    : m_fallbackSvg(fallbackSvg),
+      m_fallbackHash(coefficient_cache::hashSource(std::string_view(fallbackSvg.data(), fallbackSvg.size()))),
+      m_fallbackSnapshot(fallbackSnapshot), m_offsetX(offsetX), m_scale(scale)
+{
+#if SVG_LOADER_THREADED
+    m_worker = std::jthread([this](const std::stop_token stop) { workerLoop(stop); });
+#endif
+}
+
+SvgLoader::~SvgLoader()
+{
+#if SVG_LOADER_THREADED
+    m_worker.request_stop();
+    m_wake.notify_all();
+#endif
+}
+
+void SvgLoader::setCacheDirectory(std::string directory)
+{
+    if (!directory.empty())
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec)
+        {
+            SDL_Log("Coefficient cache disabled, cannot create %s: %s", directory.c_str(), ec.message().c_str());
+            directory.clear();
+        }
+    }
+    m_cacheDirectory = std::move(directory);
+}
+
+void SvgLoader::request(std::string path, const int sampleCount)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        const std::uint64_t generation = m_generation.load(std::memory_order_relaxed) + 1;
+        m_generation.store(generation, std::memory_order_release);
+
+        Job job;
+        job.generation = generation;
+        job.result.path = std::move(path);
+        job.result.sampleCount = sampleCount;
+        m_pending = std::move(job);
+        m_finished.reset();
+    }
+#if SVG_LOADER_THREADED
+    m_wake.notify_one();
+#endif
+}
+
+std::optional<SvgLoader::Result> SvgLoader::poll()
+{
+#if !SVG_LOADER_THREADED
+    if (!m_active && m_pending)
+    {
+        m_active = std::move(m_pending);
+        m_pending.reset();
+    }
+    if (m_active)
+    {
+        runStage(*m_active);
+        if (superseded(*m_active))
+        {
+            m_active.reset();
+        }
+        else if (m_active->stage == Stage::Done)
+        {
+            finish(*m_active);
+            m_active.reset();
+        }
+    }
+#endif
+
+    std::lock_guard lock(m_mutex);
+    if (!m_finished) return std::nullopt;
+
+    std::optional<Result> result = std::move(m_finished);
+    m_finished.reset();
+    m_delivered = m_generation.load(std::memory_order_relaxed);
+    return result;
+}
+
+void SvgLoader::runStage(Job& job)
+{
+    Result& result = job.result;
+    const auto perPath = [this](const std::size_t count, auto&& fn) { m_pool.parallelFor(count, fn); };
+    switch (job.stage)
+    {
+    case Stage::Flatten:
+    {
+        std::string text;
+        bool fromFile = false;
+        if (!result.path.empty())
+        {
+            fromFile = readFile(result.path, text);
+            if (!fromFile) SDL_Log("Failed to read SVG file: %s, using embedded default", result.path.c_str());
+        }
+
+        job.key = fromFile
+                      ? coefficient_cache::makeKey(text, result.sampleCount, m_offsetX, m_scale)
+                      : coefficient_cache::makeKey(m_fallbackHash, result.sampleCount, m_offsetX, m_scale);
+        if (restoreFromCache(job))
+        {
+            job.stage = Stage::Done;
+            break;
+        }
+
+        if (!m_flattenedValid || job.key.sourceHash != m_flattenedHash)
+        {
+            if (!fromFile || m_flattener.flattenString(text, perPath).empty())
+            {
+                if (fromFile) SDL_Log("Failed to load SVG from file: %s, using embedded default", result.path.c_str());
+                // Fall back to the embedded SVG, parsed in place the first time round
+                if (!m_fallbackParsed)
+                {
+                    m_fallbackImage = svg::parseInPlace(m_fallbackSvg);
+                    m_fallbackParsed = true;
+                }
+                if (m_fallbackImage) m_flattener.flatten(*m_fallbackImage, svg::FLATTEN_TOLERANCE, perPath);
+                else m_flattener.flatten(nullptr);
+            }
+            m_flattenedHash = job.key.sourceHash;
+            m_flattenedValid = true;
+        }
+        job.stage = Stage::Resample;
+        break;
+    }
+
+    case Stage::Resample:
+        result.points = svg::resample(m_flattener.result(), static_cast<std::size_t>(result.sampleCount), perPath);
+        for (auto& point : result.points)
+        {
+            point.x += m_offsetX;
+            point *= m_scale;
+        }
+        job.stage = Stage::Transform;
+        break;
+
+    case Stage::Transform:
+        result.circles.calculateCoefficients(result.points);
+        // The app starts with every vector active; ordering them here keeps that sort off the main thread
+        result.circles.orderCoefficients(static_cast<std::size_t>(result.sampleCount));
+        saveToCache(job);
+        job.stage = Stage::Done;
+        break;
+
+    case Stage::Done:
+        break;
+    }
+}
+
+bool SvgLoader::restoreFromCache(Job& job) const
+{
+    coefficient_cache::Snapshot snapshot;
+    bool restored = false;
+    if (job.result.path.empty() && !m_fallbackSnapshot.empty())
+    {
+        restored = coefficient_cache::deserialize(m_fallbackSnapshot, job.key, snapshot);
+    }
+    if (!restored && !m_cacheDirectory.empty())
+    {
+        const std::string file = m_cacheDirectory + "/" + coefficient_cache::fileName(job.key);
+        restored = coefficient_cache::load(file, job.key, snapshot);
+    }
+    if (!restored) return false;
+
+    job.result.points = std::move(snapshot.points);
+    job.result.circles = std::move(snapshot.circles);
+    return true;
+}
+
+void SvgLoader::saveToCache(Job& job) const
+{
+    if (m_cacheDirectory.empty()) return;
+
+    const std::string file = m_cacheDirectory + "/" + coefficient_cache::fileName(job.key);
+    const auto data = coefficient_cache::serialize(job.key, job.result.points, job.result.circles);
+    job.result.cacheWritten = coefficient_cache::store(file, data);
+    if (!job.result.cacheWritten) SDL_Log("Failed to write coefficient cache: %s", file.c_str());
+}
+
+void SvgLoader::finish(Job& job)
+{
+    std::lock_guard lock(m_mutex);
+    // A request that arrived meanwhile has already cleared m_finished and owns the generation
+    if (job.generation == m_generation.load(std::memory_order_relaxed))
+    {
+        m_finished = std::move(job.result);
+    }
+}
+
+#if SVG_LOADER_THREADED
+void SvgLoader::workerLoop(const std::stop_token stop)
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock lock(m_mutex);
+            if (!m_wake.wait(lock, stop, [this] { return m_pending.has_value(); })) return;
+            job = std::move(*m_pending);
+            m_pending.reset();
+        }
+
+        while (job.stage != Stage::Done && !superseded(job) && !stop.stop_requested())
+        {
+            runStage(job);
+        }
+        if (job.stage == Stage::Done)
+        {
+            finish(job);
+        }
+    }
+}
+#endif
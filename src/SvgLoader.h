@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define SVG_LOADER_THREADED 1
+#include <condition_variable>
+#include <thread>
+#else
+#define SVG_LOADER_THREADED 0
+#endif
+
+#include "CoefficientCache.h"
+#include "FourierCircles.h"
+#include "ThreadPool.h"
+#include "Vec2.h"
+#include "svg.h"
+
+// Parses, resamples and transforms SVG files away from the render loop. Each request supersedes the previous one,
+// whose work is abandoned at the next stage boundary. With threads the stages run on a worker; single-threaded
+// Emscripten builds advance one stage per poll() instead, so a load is spread over several frames.
+// Finished loads are saved to the coefficient cache and a later load of the same source and count restores them
+// without parsing or transforming anything.
+class SvgLoader
+{
+public:
+    struct Result
+    {
+        std::string path; // as requested, empty for the embedded default
+        int sampleCount = 0;
+        std::vector<geometry::Vec2f> points;
+        FourierCircles circles;
+        bool cacheWritten = false; // a new snapshot was stored in the cache directory
+    };
+
+    // `fallbackSvg` is loaded for an empty path or when a file fails to parse, `fallbackSnapshot` is its build-time
+    // coefficient cache (may be empty). The fallback text must be followed by a NUL; it is parsed in place the
+    // first time it is needed, so it is hashed up front and not read again after that. Points are shifted by
+    // offsetX and then multiplied by scale before the transform.
+    SvgLoader(std::span<char> fallbackSvg, std::span<const std::byte> fallbackSnapshot, float offsetX, float scale);
+    ~SvgLoader();
+
+    SvgLoader(const SvgLoader&) = delete;
+    SvgLoader& operator=(const SvgLoader&) = delete;
+
+    // Directory for cache snapshots, created if missing; empty disables the cache. Call before the first request.
+    void setCacheDirectory(std::string directory);
+
+    void request(std::string path, int sampleCount);
+
+    // Result of the latest request once it is done, handed out once. Call from the main thread every frame.
+    [[nodiscard]] std::optional<Result> poll();
+
+    // True from request() until its result has been handed out by poll()
+    [[nodiscard]] bool busy() const { return m_delivered != m_generation.load(std::memory_order_relaxed); }
+
+private:
+    enum class Stage { Flatten, Resample, Transform, Done };
+
+    struct Job
+    {
+        std::uint64_t generation = 0;
+        Stage stage = Stage::Flatten;
+        coefficient_cache::Key key;
+        Result result;
+    };
+
+    // Runs the job's current stage and advances it
+    void runStage(Job& job);
+    [[nodiscard]] bool superseded(const Job& job) const
+    {
+        return job.generation != m_generation.load(std::memory_order_acquire);
+    }
+    void finish(Job& job);
+    // Restores the job's result from the build-time or on-disk snapshot
+    [[nodiscard]] bool restoreFromCache(Job& job) const;
+    void saveToCache(Job& job) const;
+
+    std::span<char> m_fallbackSvg;
+    std::uint64_t m_fallbackHash;
+    std::span<const std::byte> m_fallbackSnapshot;
+    std::string m_cacheDirectory;
+    float m_offsetX;
+    float m_scale;
+
+    // Flattened path of the last parsed source, reused when only the sample count changes. Touched only by whoever
+    // runs the stages.
+    svg::Flattener m_flattener;
+    std::uint64_t m_flattenedHash = 0;
+    bool m_flattenedValid = false;
+    // Parsed out of m_fallbackSvg on first use and kept, the text itself is consumed by the parse
+    svg::NSVGimagePtr m_fallbackImage;
+    bool m_fallbackParsed = false;
+    // Flattening and resampling go through it path by path; separate from the render pool so a load never holds
+    // up a frame's parallel work
+    ThreadPool m_pool;
+
+    std::atomic<std::uint64_t> m_generation{0};
+    std::uint64_t m_delivered = 0; // main thread only
+
+    std::mutex m_mutex; // guards m_pending and m_finished
+    std::optional<Job> m_pending;
+    std::optional<Result> m_finished;
+
+#if SVG_LOADER_THREADED
+    void workerLoop(std::stop_token stop);
+
+    std::condition_variable_any m_wake;
+    std::jthread m_worker; // declared last so it is joined before the members it uses go away
+#else
+    std::optional<Job> m_active;
+#endif
+};
@@ -21,16 +21,18 @@ bool TextRenderer::init(SDL_Renderer* renderer, const std::string& fontPath, con
         {
             const std::streamsize fileSize = file.tellg();
             file.seekg(0, std::ios::beg);
-            m_fontData.resize(fileSize);
-            if (file.read(reinterpret_cast<char*>(m_fontData.data()), fileSize))
+            m_fontFile.resize(fileSize);
+            if (file.read(reinterpret_cast<char*>(m_fontFile.data()), fileSize))
             {
+                m_fontData = m_fontFile;
                 return buildAtlas();
             }
         }
         SDL_Log("Failed to read font file: %s, using embedded font", fontPath.c_str());
     }
 
-    m_fontData.assign(embedded_font_data, embedded_font_data + embedded_font_data_len);
+    m_fontData = embedded_font_data;
+    m_fontFile.clear();
     return buildAtlas();
 }
 
@@ -38,7 +40,8 @@ bool TextRenderer::init(SDL_Renderer* renderer, const std::span<const uint8_t> f
 {
     m_renderer = renderer;
     m_fontSize = fontSize;
-    m_fontData.assign(fontData.begin(), fontData.end());
+    m_fontData = fontData;
+    m_fontFile.clear();
     return buildAtlas();
 }
 
@@ -183,6 +186,7 @@ bool TextRenderer::buildAtlas()
 
     SDL_SetTextureBlendMode(m_atlasTexture, SDL_BLENDMODE_BLEND);
     SDL_UpdateTexture(m_atlasTexture, nullptr, rgbaData.data(), atlasWidth * 4);
+    ++m_atlasGeneration;
 
     return true;
 }
@@ -223,6 +227,56 @@ void TextRenderer::renderText(const float x, const float y, const std::string_vi
     }
 }
 
+void TextRenderer::buildTextBlock(TextBlock& block, const float x, const float y, const float lineSpacing,
+                                  const std::span<const std::string> lines, const SDL_FColor color) const
+{
+    block.vertices.clear();
+    block.indices.clear();
+    block.atlasGeneration = m_atlasGeneration;
+
+    float penY = y;
+    for (const std::string& line : lines)
+    {
+        float penX = x;
+        for (const char c : line)
+        {
+            if (c < FIRST_CHAR || c > LAST_CHAR) continue;
+
+            const auto& [texCoords, bounds, advance] = m_glyphs[c - FIRST_CHAR];
+            if (bounds.w > 0 && bounds.h > 0)
+            {
+                const float x0 = penX + bounds.x;
+                const float y0 = penY + bounds.y;
+                const float x1 = x0 + bounds.w;
+                const float y1 = y0 + bounds.h;
+                const float u0 = texCoords.x;
+                const float v0 = texCoords.y;
+                const float u1 = texCoords.x + texCoords.w;
+                const float v1 = texCoords.y + texCoords.h;
+
+                const int base = static_cast<int>(block.vertices.size());
+                block.vertices.push_back({{x0, y0}, color, {u0, v0}});
+                block.vertices.push_back({{x1, y0}, color, {u1, v0}});
+                block.vertices.push_back({{x1, y1}, color, {u1, v1}});
+                block.vertices.push_back({{x0, y1}, color, {u0, v1}});
+                block.indices.insert(block.indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+            }
+
+            penX += advance;
+        }
+        penY += lineSpacing;
+    }
+}
+
+void TextRenderer::renderTextBlock(const TextBlock& block) const
+{
+    if (!m_atlasTexture || block.indices.empty()) return;
+
+    SDL_RenderGeometry(m_renderer, m_atlasTexture,
+                       block.vertices.data(), static_cast<int>(block.vertices.size()),
+                       block.indices.data(), static_cast<int>(block.indices.size()));
+}
+
 geometry::Vec2f TextRenderer::measureText(const std::string_view text) const
 {
     float width = 0.0f;
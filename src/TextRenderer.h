@@ -20,8 +20,18 @@ public:
         float advance;
     };
 
+    // Pre-built quads for a block of text lines, drawn with a single SDL_RenderGeometry call
+    struct TextBlock
+    {
+        std::vector<SDL_Vertex> vertices;
+        std::vector<int> indices;
+        std::uint64_t atlasGeneration = 0; // atlas the texture coordinates refer to, 0 = never built
+    };
+
     TextRenderer() = default;
+    // An empty or unreadable path uses the embedded font
     bool init(SDL_Renderer* renderer, const std::string& fontPath, float fontSize);
+    // Uses `fontData` in place, so it has to outlive the renderer
     bool init(SDL_Renderer* renderer, std::span<const uint8_t> fontData, float fontSize);
 
     ~TextRenderer();
@@ -35,6 +45,13 @@ public:
 
     void renderText(float x, float y, std::string_view text) const;
 
+    // Lays out `lines` top to bottom starting at (x, y), replacing the previous contents of `block`
+    void buildTextBlock(TextBlock& block, float x, float y, float lineSpacing,
+                        std::span<const std::string> lines, SDL_FColor color) const;
+    void renderTextBlock(const TextBlock& block) const;
+    // False once the atlas was rebuilt (e.g. DPI change) after the block was laid out
+    [[nodiscard]] bool isCurrent(const TextBlock& block) const { return block.atlasGeneration == m_atlasGeneration; }
+
     [[nodiscard]] geometry::Vec2f measureText(std::string_view text) const;
 
     [[nodiscard]] float getFontSize() const { return m_fontSize; }
@@ -47,7 +64,8 @@ private:
 
     SDL_Renderer* m_renderer = nullptr;
 
-    std::vector<uint8_t> m_fontData;
+    std::span<const uint8_t> m_fontData; // the embedded font, caller data or m_fontFile
+    std::vector<uint8_t> m_fontFile;
     float m_fontSize = 0.0f;
 
     static constexpr int FIRST_CHAR = 32;
@@ -58,4 +76,5 @@ private:
 
     int m_atlasWidth = 0;
     int m_atlasHeight = 0;
+    std::uint64_t m_atlasGeneration = 0;
 };
@@ -0,0 +1,121 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(const std::size_t workers)
+{
+    const std::size_t threads = THREAD_POOL_THREADED ? workers : 0;
+    for (std::size_t i = 0; i <= threads; ++i) m_queues.push_back(std::make_unique<Queue>());
+
+#if THREAD_POOL_THREADED
+    m_workers.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i)
+    {
+        m_workers.emplace_back([this, i](const std::stop_token stop) { workerLoop(stop, i + 1); });
+    }
+#endif
+}
+
+ThreadPool::~ThreadPool()
+{
+#if THREAD_POOL_THREADED
+    for (auto& worker : m_workers) worker.request_stop();
+    m_wake.notify_all();
+    m_workers.clear();
+#endif
+}
+
+std::size_t ThreadPool::defaultWorkers()
+{
+#if THREAD_POOL_THREADED
+    const unsigned hardware = std::thread::hardware_concurrency();
+    const std::size_t workers = hardware > 1 ? hardware - 1 : 0;
+#ifdef __EMSCRIPTEN__
+    return std::min(workers, WEB_MAX_WORKERS);
+#else
+    return workers;
+#endif
+#else
+    return 0;
+#endif
+}
+
+void ThreadPool::run(const std::size_t count, const ChunkFn fn, void* context)
+{
+    if (count == 0) return;
+    if (m_queues.size() == 1 || count == 1)
+    {
+        fn(context, 0, count);
+        return;
+    }
+
+    const std::size_t chunks = std::min(count, m_queues.size() * CHUNKS_PER_THREAD);
+    Batch batch{fn, context, chunks};
+    for (std::size_t c = 0; c < chunks; ++c)
+    {
+        Queue& queue = *m_queues[c % m_queues.size()];
+        std::lock_guard lock(queue.mutex);
+        queue.chunks.push_back({&batch, count * c / chunks, count * (c + 1) / chunks});
+    }
+
+#if THREAD_POOL_THREADED
+    {
+        // Published under the sleep mutex so a worker between its check and its wait cannot miss the wakeup
+        std::lock_guard lock(m_sleepMutex);
+        m_queued.fetch_add(chunks, std::memory_order_release);
+    }
+    m_wake.notify_all();
+#endif
+
+    // Help until nothing is left to take, then wait for the chunks still running elsewhere
+    while (batch.remaining.load(std::memory_order_acquire) > 0)
+    {
+        if (!runOne(0))
+        {
+#if THREAD_POOL_THREADED
+            std::this_thread::yield();
+#endif
+        }
+    }
+}
+
+bool ThreadPool::runOne(const std::size_t self)
+{
+    Chunk chunk{};
+    bool found = false;
+    for (std::size_t k = 0; k < m_queues.size() && !found; ++k)
+    {
+        const std::size_t index = (self + k) % m_queues.size();
+        Queue& queue = *m_queues[index];
+        std::lock_guard lock(queue.mutex);
+        if (queue.chunks.empty()) continue;
+        if (index == self)
+        {
+            chunk = queue.chunks.back();
+            queue.chunks.pop_back();
+        }
+        else
+        {
+            chunk = queue.chunks.front();
+            queue.chunks.pop_front();
+        }
+        found = true;
+    }
+    if (!found) return false;
+
+    m_queued.fetch_sub(1, std::memory_order_relaxed);
+    chunk.batch->fn(chunk.batch->context, chunk.begin, chunk.end);
+    chunk.batch->remaining.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+#if THREAD_POOL_THREADED
+void ThreadPool::workerLoop(const std::stop_token stop, const std::size_t self)
+{
+    while (!stop.stop_requested())
+    {
+        if (runOne(self)) continue;
+
+        std::unique_lock lock(m_sleepMutex);
+        m_wake.wait(lock, stop, [this] { return m_queued.load(std::memory_order_acquire) > 0; });
+    }
+}
+#endif
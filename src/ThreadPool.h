@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define THREAD_POOL_THREADED 1
+#include <condition_variable>
+#include <thread>
+#else
+#define THREAD_POOL_THREADED 0
+#endif
+
+// Fork-join pool for per-frame data parallel work. parallelFor cuts a range into chunks spread over one deque per
+// worker; a worker takes from the back of its own deque and steals from the front of the others' when it runs dry,
+// and the calling thread works through the chunks too until all of them are done. Without threads (single-threaded
+// Emscripten) everything runs inline on the caller.
+class ThreadPool
+{
+public:
+    // Chunks per participating thread, more than one so stealing can even out uneven items
+    static constexpr std::size_t CHUNKS_PER_THREAD = 4;
+
+    // Upper bound of defaultWorkers() in pthread Emscripten builds, whose workers come out of a pool pre-spawned at
+    // startup; PTHREAD_POOL_SIZE in CMakeLists.txt counts on it
+    static constexpr std::size_t WEB_MAX_WORKERS = 3;
+
+    // `workers` threads besides the caller; by default one less than the hardware threads
+    explicit ThreadPool(std::size_t workers = defaultWorkers());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Calls fn(i) for every i in [0, count) and returns once all calls are done. fn must not throw and must be
+    // safe to call concurrently for different i.
+    template <typename Fn>
+    void parallelFor(const std::size_t count, Fn&& fn)
+    {
+        auto* target = &fn;
+        run(count, [](void* context, const std::size_t begin, const std::size_t end)
+        {
+            auto& f = *static_cast<decltype(target)>(context);
+            for (std::size_t i = begin; i < end; ++i) f(i);
+        }, target);
+    }
+
+    // Threads that take part in parallelFor, the caller included
+    [[nodiscard]] std::size_t concurrency() const { return m_queues.size(); }
+
+    [[nodiscard]] static std::size_t defaultWorkers();
+
+private:
+    using ChunkFn = void (*)(void* context, std::size_t begin, std::size_t end);
+
+    struct Batch
+    {
+        ChunkFn fn;
+        void* context;
+        std::atomic<std::size_t> remaining; // chunks not finished yet
+    };
+
+    struct Chunk
+    {
+        Batch* batch;
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Chunk> chunks;
+    };
+
+    void run(std::size_t count, ChunkFn fn, void* context);
+    // Runs one chunk from queue `self`, or stolen from another; false when every queue is empty
+    bool runOne(std::size_t self);
+
+    // m_queues[0] belongs to the calling thread, m_queues[i + 1] to worker i
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::atomic<std::size_t> m_queued{0};
+
+#if THREAD_POOL_THREADED
+    void workerLoop(std::stop_token stop, std::size_t self);
+
+    std::mutex m_sleepMutex;
+    std::condition_variable_any m_wake;
+    std::vector<std::jthread> m_workers; // declared last so they are joined before the queues go away
+#endif
+};
@@ -5,11 +5,31 @@
 #include <cmath>
 #include <numbers>
 #include <cstddef>
+#include <cstdint>
 #include <stdexcept>
 #include <algorithm>
+#include <array>
 #include <bit>
+#include <memory>
 #include "Vec2.h"
 
+// SIMD kernels are picked at compile time from the target flags; FFT_FORCE_SCALAR keeps the scalar reference path.
+#if !defined(FFT_FORCE_SCALAR)
+#if defined(__AVX2__)
+#define FFT_SIMD_AVX2 1
+#include <immintrin.h>
+#elif defined(__wasm_simd128__)
+#define FFT_SIMD_WASM 1
+#include <wasm_simd128.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#define FFT_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#define FFT_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
+
 namespace fft
 {
     using geometry::Vec2f;
@@ -43,6 +63,351 @@ namespace fft
         }
 
         inline constexpr float PI = std::numbers::pi_v<float>;
+
+        // Float batches for the split re/im kernels. Scalar is width 1 and always available, Native is the widest
+        // batch of the compile target (or Scalar when there is none).
+        namespace simd
+        {
+            struct Scalar
+            {
+                static constexpr std::size_t width = 1;
+                float v;
+
+                static Scalar load(const float* p) noexcept { return {*p}; }
+                void store(float* p) const noexcept { *p = v; }
+                friend Scalar operator+(const Scalar a, const Scalar b) noexcept { return {a.v + b.v}; }
+                friend Scalar operator-(const Scalar a, const Scalar b) noexcept { return {a.v - b.v}; }
+                friend Scalar operator*(const Scalar a, const Scalar b) noexcept { return {a.v * b.v}; }
+            };
+
+#if defined(FFT_SIMD_AVX2)
+            struct Native
+            {
+                static constexpr std::size_t width = 8;
+                __m256 v;
+
+                static Native load(const float* p) noexcept { return {_mm256_loadu_ps(p)}; }
+                void store(float* p) const noexcept { _mm256_storeu_ps(p, v); }
+                friend Native operator+(const Native a, const Native b) noexcept { return {_mm256_add_ps(a.v, b.v)}; }
+                friend Native operator-(const Native a, const Native b) noexcept { return {_mm256_sub_ps(a.v, b.v)}; }
+                friend Native operator*(const Native a, const Native b) noexcept { return {_mm256_mul_ps(a.v, b.v)}; }
+            };
+#elif defined(FFT_SIMD_WASM)
+            struct Native
+            {
+                static constexpr std::size_t width = 4;
+                v128_t v;
+
+                static Native load(const float* p) noexcept { return {wasm_v128_load(p)}; }
+                void store(float* p) const noexcept { wasm_v128_store(p, v); }
+                friend Native operator+(const Native a, const Native b) noexcept { return {wasm_f32x4_add(a.v, b.v)}; }
+                friend Native operator-(const Native a, const Native b) noexcept { return {wasm_f32x4_sub(a.v, b.v)}; }
+                friend Native operator*(const Native a, const Native b) noexcept { return {wasm_f32x4_mul(a.v, b.v)}; }
+            };
+#elif defined(FFT_SIMD_SSE2)
+            struct Native
+            {
+                static constexpr std::size_t width = 4;
+                __m128 v;
+
+                static Native load(const float* p) noexcept { return {_mm_loadu_ps(p)}; }
+                void store(float* p) const noexcept { _mm_storeu_ps(p, v); }
+                friend Native operator+(const Native a, const Native b) noexcept { return {_mm_add_ps(a.v, b.v)}; }
+                friend Native operator-(const Native a, const Native b) noexcept { return {_mm_sub_ps(a.v, b.v)}; }
+                friend Native operator*(const Native a, const Native b) noexcept { return {_mm_mul_ps(a.v, b.v)}; }
+            };
+#elif defined(FFT_SIMD_NEON)
+            struct Native
+            {
+                static constexpr std::size_t width = 4;
+                float32x4_t v;
+
+                static Native load(const float* p) noexcept { return {vld1q_f32(p)}; }
+                void store(float* p) const noexcept { vst1q_f32(p, v); }
+                friend Native operator+(const Native a, const Native b) noexcept { return {vaddq_f32(a.v, b.v)}; }
+                friend Native operator-(const Native a, const Native b) noexcept { return {vsubq_f32(a.v, b.v)}; }
+                friend Native operator*(const Native a, const Native b) noexcept { return {vmulq_f32(a.v, b.v)}; }
+            };
+#else
+            using Native = Scalar;
+#endif
+
+            // (ar + i ai) * (br + i bi), or times the conjugate of b when Conj is set
+            template <bool Conj, class V>
+            inline void cmul(const V ar, const V ai, const V br, const V bi, V& out_r, V& out_i) noexcept
+            {
+                if constexpr (Conj)
+                {
+                    out_r = ar * br + ai * bi;
+                    out_i = ai * br - ar * bi;
+                }
+                else
+                {
+                    out_r = ar * br - ai * bi;
+                    out_i = ar * bi + ai * br;
+                }
+            }
+
+            // One radix-4 stage over the blocks of a bit-reversed split array. Blocks hold the sub-DFTs F0, F2, F1,
+            // F3 (radix-2 bit-reversed order); tw_re/tw_im hold W^j, W^2j, W^3j as three runs of q values.
+            template <class V, bool Inverse>
+            inline void radix4_stage(float* re, float* im, const std::size_t n, const std::size_t q,
+                                     const float* tw_re, const float* tw_im) noexcept
+            {
+                for (std::size_t i = 0; i < n; i += 4 * q)
+                {
+                    float* xr = re + i;
+                    float* xi = im + i;
+                    for (std::size_t j = 0; j < q; j += V::width)
+                    {
+                        V t1r, t1i, t2r, t2i, t3r, t3i;
+                        cmul<Inverse>(V::load(xr + j + 2 * q), V::load(xi + j + 2 * q),
+                                      V::load(tw_re + j), V::load(tw_im + j), t1r, t1i);
+                        cmul<Inverse>(V::load(xr + j + q), V::load(xi + j + q),
+                                      V::load(tw_re + q + j), V::load(tw_im + q + j), t2r, t2i);
+                        cmul<Inverse>(V::load(xr + j + 3 * q), V::load(xi + j + 3 * q),
+                                      V::load(tw_re + 2 * q + j), V::load(tw_im + 2 * q + j), t3r, t3i);
+
+                        const V t0r = V::load(xr + j);
+                        const V t0i = V::load(xi + j);
+
+                        const V s02r = t0r + t2r, s02i = t0i + t2i;
+                        const V d02r = t0r - t2r, d02i = t0i - t2i;
+                        const V s13r = t1r + t3r, s13i = t1i + t3i;
+                        const V d13r = t1r - t3r, d13i = t1i - t3i;
+
+                        (s02r + s13r).store(xr + j);
+                        (s02i + s13i).store(xi + j);
+                        (s02r - s13r).store(xr + j + 2 * q);
+                        (s02i - s13i).store(xi + j + 2 * q);
+
+                        // -i * d13 for the forward transform, +i * d13 for the inverse
+                        if constexpr (Inverse)
+                        {
+                            (d02r - d13i).store(xr + j + q);
+                            (d02i + d13r).store(xi + j + q);
+                            (d02r + d13i).store(xr + j + 3 * q);
+                            (d02i - d13r).store(xi + j + 3 * q);
+                        }
+                        else
+                        {
+                            (d02r + d13i).store(xr + j + q);
+                            (d02i - d13r).store(xi + j + q);
+                            (d02r - d13i).store(xr + j + 3 * q);
+                            (d02i + d13r).store(xi + j + 3 * q);
+                        }
+                    }
+                }
+            }
+
+            // a = a * b elementwise on split arrays
+            template <class V>
+            inline std::size_t pointwise_mul(float* ar, float* ai, const float* br, const float* bi,
+                                             const std::size_t n) noexcept
+            {
+                std::size_t i = 0;
+                for (; i + V::width <= n; i += V::width)
+                {
+                    V r, im;
+                    cmul<false>(V::load(ar + i), V::load(ai + i), V::load(br + i), V::load(bi + i), r, im);
+                    r.store(ar + i);
+                    im.store(ai + i);
+                }
+                return i;
+            }
+        } // namespace simd
+
+        // Fully compile-time transforms for a fixed set of sizes built from the factors 2, 3 and 5: a recursive
+        // mixed-radix decimation in time whose sizes, strides and radices are template parameters and whose
+        // twiddles are constexpr tables, so every stage is straight-line code over constants. They replace the
+        // Bluestein setup (three padded transforms) for the sample counts people actually pick.
+        namespace fixed
+        {
+            // Sizes with a specialized kernel. Powers of two are left to the SIMD radix-4 path, which is faster.
+            template <std::size_t... Ns>
+            struct SizeList
+            {
+            };
+
+            using Sizes = SizeList<10, 12, 20, 24, 25, 30, 40, 48, 50, 60, 75, 80, 96, 100, 120, 125, 150, 160,
+                                   200, 240, 250, 300, 400, 500, 600, 750, 800, 1000>;
+
+            using Kernel = void (*)(const Vec2f* in, Vec2f* out) noexcept;
+
+            // Series sin/cos for the constexpr tables; x within [-pi, pi]
+            constexpr void sincos(const double x, double& s, double& c) noexcept
+            {
+                double term_s = x, term_c = 1.0;
+                s = 0.0;
+                c = 0.0;
+                for (int k = 0; k < 24; ++k)
+                {
+                    s += term_s;
+                    c += term_c;
+                    term_s *= -x * x / static_cast<double>((2 * k + 2) * (2 * k + 3));
+                    term_c *= -x * x / static_cast<double>((2 * k + 1) * (2 * k + 2));
+                }
+            }
+
+            // W_N^j = e^{-2 pi i j / N}
+            template <std::size_t N>
+            constexpr std::array<Vec2f, N> makeTwiddles() noexcept
+            {
+                std::array<Vec2f, N> tw{};
+                for (std::size_t j = 0; j < N; ++j)
+                {
+                    // angle within [-pi, pi] for the series
+                    const auto signed_j = static_cast<double>(j <= N / 2 ? static_cast<long long>(j)
+                                                                         : static_cast<long long>(j) -
+                                                                           static_cast<long long>(N));
+                    double s, c;
+                    sincos(-2.0 * std::numbers::pi * signed_j / static_cast<double>(N), s, c);
+                    tw[j] = {static_cast<float>(c), static_cast<float>(s)};
+                }
+                return tw;
+            }
+
+            template <std::size_t N>
+            inline constexpr std::array<Vec2f, N> twiddles = makeTwiddles<N>();
+
+            constexpr bool isSmooth(std::size_t n) noexcept
+            {
+                for (const std::size_t f : {2u, 3u, 5u})
+                    while (n % f == 0)
+                        n /= f;
+                return n == 1;
+            }
+
+            // Radix taken off the front of n: 4 as long as it divides, then 2, 3 and 5
+            constexpr std::size_t radix(const std::size_t n) noexcept
+            {
+                if (n % 4 == 0) return 4;
+                if (n % 2 == 0) return 2;
+                if (n % 3 == 0) return 3;
+                return 5;
+            }
+
+            template <bool Inverse>
+            inline Vec2f twiddle(const Vec2f a, const Vec2f w) noexcept
+            {
+                return Inverse ? cmul(a, cconj(w)) : cmul(a, w);
+            }
+
+            // -i * a for the forward transform, +i * a for the inverse
+            template <bool Inverse>
+            inline Vec2f rotateQuarter(const Vec2f a) noexcept
+            {
+                return Inverse ? Vec2f{-a.y, a.x} : Vec2f{a.y, -a.x};
+            }
+
+            // In-place DFT of R points
+            template <std::size_t R, bool Inverse>
+            inline void butterfly(Vec2f* a) noexcept
+            {
+                if constexpr (R == 2)
+                {
+                    const Vec2f t = a[1];
+                    a[1] = csub(a[0], t);
+                    a[0] = cadd(a[0], t);
+                }
+                else if constexpr (R == 4)
+                {
+                    const Vec2f s02 = cadd(a[0], a[2]), d02 = csub(a[0], a[2]);
+                    const Vec2f s13 = cadd(a[1], a[3]), d13 = rotateQuarter<Inverse>(csub(a[1], a[3]));
+                    a[0] = cadd(s02, s13);
+                    a[1] = cadd(d02, d13);
+                    a[2] = csub(s02, s13);
+                    a[3] = csub(d02, d13);
+                }
+                else if constexpr (R == 3)
+                {
+                    constexpr float SIN_60 = 0.866025403784438647f;
+                    const Vec2f sum = cadd(a[1], a[2]);
+                    const Vec2f mid = csub(a[0], cscale(sum, 0.5f));
+                    const Vec2f rot = cscale(rotateQuarter<Inverse>(csub(a[1], a[2])), SIN_60);
+                    a[0] = cadd(a[0], sum);
+                    a[1] = cadd(mid, rot);
+                    a[2] = csub(mid, rot);
+                }
+                else
+                {
+                    static_assert(R == 5);
+                    // Pairs r, 5 - r share the cosines and have opposite sines
+                    constexpr float C1 = 0.309016994374947424f, C2 = -0.809016994374947424f; // cos(2pi/5), cos(4pi/5)
+                    constexpr float S1 = 0.951056516295153572f, S2 = 0.587785252292473129f; // sin(2pi/5), sin(4pi/5)
+                    const Vec2f t1 = cadd(a[1], a[4]), t2 = cadd(a[2], a[3]);
+                    const Vec2f t3 = csub(a[1], a[4]), t4 = csub(a[2], a[3]);
+                    const Vec2f b1 = cadd(a[0], cadd(cscale(t1, C1), cscale(t2, C2)));
+                    const Vec2f b2 = cadd(a[0], cadd(cscale(t1, C2), cscale(t2, C1)));
+                    const Vec2f r1 = rotateQuarter<Inverse>(cadd(cscale(t3, S1), cscale(t4, S2)));
+                    const Vec2f r2 = rotateQuarter<Inverse>(csub(cscale(t3, S2), cscale(t4, S1)));
+                    a[0] = cadd(a[0], cadd(t1, t2));
+                    a[1] = cadd(b1, r1);
+                    a[4] = csub(b1, r1);
+                    a[2] = cadd(b2, r2);
+                    a[3] = csub(b2, r2);
+                }
+            }
+
+            // DFT of in[0], in[Stride], ..., in[(N - 1) * Stride] into out[0, N): R sub-transforms of the
+            // interleaved inputs into consecutive blocks of out, then per k one twiddled butterfly over
+            // out[k], out[k + M], ..., which reads and writes the same slots
+            template <std::size_t Top, std::size_t N, std::size_t Stride, bool Inverse>
+            inline void transform(const Vec2f* in, Vec2f* out) noexcept
+            {
+                constexpr std::size_t R = radix(N);
+                constexpr std::size_t M = N / R;
+                if constexpr (M == 1)
+                {
+                    // Leaf: one butterfly straight from the strided input
+                    Vec2f a[R];
+                    for (std::size_t r = 0; r < R; ++r)
+                        a[r] = in[r * Stride];
+                    butterfly<R, Inverse>(a);
+                    for (std::size_t q = 0; q < R; ++q)
+                        out[q] = a[q];
+                }
+                else
+                {
+                    constexpr std::size_t STEP = Top / N; // W_N^j = W_Top^{j * STEP}
+                    for (std::size_t r = 0; r < R; ++r)
+                        transform<Top, M, Stride * R, Inverse>(in + r * Stride, out + r * M);
+
+                    const auto& tw = twiddles<Top>;
+                    for (std::size_t k = 0; k < M; ++k)
+                    {
+                        Vec2f a[R];
+                        a[0] = out[k];
+                        for (std::size_t r = 1; r < R; ++r)
+                            a[r] = k == 0 ? out[r * M] : twiddle<Inverse>(out[r * M + k], tw[r * k * STEP]);
+                        butterfly<R, Inverse>(a);
+                        for (std::size_t q = 0; q < R; ++q)
+                            out[q * M + k] = a[q];
+                    }
+                }
+            }
+
+            template <std::size_t N, bool Inverse>
+            void kernel(const Vec2f* in, Vec2f* out) noexcept
+            {
+                static_assert(isSmooth(N), "fixed kernels only factor into 2, 3 and 5");
+                transform<N, N, 1, Inverse>(in, out);
+            }
+
+            template <std::size_t... Ns>
+            constexpr Kernel find(const std::size_t n, const bool inverse, SizeList<Ns...>) noexcept
+            {
+                Kernel k = nullptr;
+                ((n == Ns ? (k = inverse ? &kernel<Ns, true> : &kernel<Ns, false>) : k), ...);
+                return k;
+            }
+
+            // Specialized kernel for a size and direction, null for sizes without one
+            constexpr Kernel find(const std::size_t n, const bool inverse) noexcept
+            {
+                return find(n, inverse, Sizes{});
+            }
+        } // namespace fixed
     } // namespace detail
 
     struct FFT
@@ -57,29 +422,41 @@ namespace fft
 
             pow2_ = detail::is_pow2(n_);
 
+            // Sizes with a compile-time kernel need no tables at all
+            fixed_ = detail::fixed::find(n_, dir_ == FFTDirection::Inverse);
+            if (fixed_)
+                return;
+
             if (pow2_)
             {
-                scratch_.resize(n_);
+                precompute_pow2(n_);
             }
             else
             {
                 m_ = std::bit_ceil(2 * n_ - 1);
-                A_.assign(m_, {});
-                B_.assign(m_, {});
-                conv_.assign(m_, {});
+                precompute_pow2(m_);
                 precompute_bluestein();
             }
         }
 
         void execute(const std::span<const Vec2f> in, const std::span<Vec2f> out) const
+        {
+            execute(in, out, default_scale());
+        }
+
+        // out = DFT(in) * scale, `scale` taking the place of the default normalization (1 forward, 1/n inverse).
+        // Runs in the plan's own buffers, so it never allocates.
+        void execute(const std::span<const Vec2f> in, const std::span<Vec2f> out, const float scale) const
         {
             if (in.size() != n_ || out.size() != n_)
                 throw std::invalid_argument("FFT::execute: size mismatch");
 
-            if (pow2_)
-                fft_radix2(in, out);
+            if (fixed_)
+                fft_fixed(in, out, scale);
+            else if (pow2_)
+                fft_radix2(in, out, scale);
             else
-                fft_bluestein(in, out);
+                fft_bluestein(in, out, scale);
         }
 
         std::vector<Vec2f> operator()(const std::vector<Vec2f>& in) const
@@ -91,84 +468,170 @@ namespace fft
 
         std::size_t size() const noexcept { return n_; }
         FFTDirection direction() const noexcept { return dir_; }
+        float default_scale() const noexcept
+        {
+            return dir_ == FFTDirection::Inverse ? 1.0f / static_cast<float>(n_) : 1.0f;
+        }
         bool is_power_of_two() const noexcept { return pow2_; }
+        // A compile-time kernel handles this size
+        bool is_fixed() const noexcept { return fixed_ != nullptr; }
 
     private:
         std::size_t n_{};
         FFTDirection dir_{FFTDirection::Forward};
         bool pow2_{false};
+        detail::fixed::Kernel fixed_{nullptr};
+
+        // Split re/im work buffers of the power-of-two kernel (size n, or m for Bluestein)
+        mutable std::vector<float> re_;
+        mutable std::vector<float> im_;
 
-        // Radix-2 buffer
-        mutable std::vector<Vec2f> scratch_;
+        // Power-of-two kernel tables
+        std::vector<std::uint32_t> bitrev_; // bit-reversed index of each position
+        std::vector<float> tw_re_; // forward twiddles of every radix-4 stage, stage after stage:
+        std::vector<float> tw_im_; // q values of W^j, then W^2j, then W^3j
+
+        // Copy of the input when a fixed kernel is asked to transform in place
+        mutable std::vector<Vec2f> alias_;
 
         // Bluestein buffers
         std::size_t m_{};
         std::vector<Vec2f> chirp_; // size n
-        mutable std::vector<Vec2f> A_; // size m
-        mutable std::vector<Vec2f> B_; // size m
-        mutable std::vector<Vec2f> conv_;
+        std::vector<float> B_re_; // size m, spectrum of the chirp kernel scaled by 1/m
+        std::vector<float> B_im_;
 
 
-        static void fft_radix2_inplace(std::vector<Vec2f>& a, const FFTDirection dir)
+        void precompute_pow2(const std::size_t len)
         {
-            using namespace detail;
+            re_.assign(len, 0.0f);
+            im_.assign(len, 0.0f);
 
-            const std::size_t n = a.size();
-            if (n <= 1) return;
+            const int bits = std::countr_zero(len);
+            bitrev_.resize(len);
+            for (std::size_t i = 0; i < len; ++i)
+            {
+                bitrev_[i] = bits == 0
+                                 ? 0u
+                                 : static_cast<std::uint32_t>(reverse_bits(static_cast<std::uint32_t>(i)) >> (32 - bits));
+            }
 
-            // bit reverse permutation
-            for (std::size_t i = 1, j = 0; i < n; ++i)
+            // An odd log2(len) leaves one radix-2 stage of length 2 (no twiddles) in front of the radix-4 stages.
+            // Angles are computed in double so large tables stay exact to float precision.
+            tw_re_.clear();
+            tw_im_.clear();
+            for (std::size_t q = (bits & 1) ? 2 : 1; 4 * q <= len; q *= 4)
             {
-                std::size_t bit = n >> 1;
-                while (j & bit)
+                for (std::size_t r = 1; r <= 3; ++r)
                 {
-                    j ^= bit;
-                    bit >>= 1;
+                    for (std::size_t j = 0; j < q; ++j)
+                    {
+                        const double ang = -2.0 * std::numbers::pi * static_cast<double>(r * j) /
+                            static_cast<double>(4 * q);
+                        tw_re_.push_back(static_cast<float>(std::cos(ang)));
+                        tw_im_.push_back(static_cast<float>(std::sin(ang)));
+                    }
                 }
-                j |= bit;
-                if (i < j) std::swap(a[i], a[j]);
             }
+        }
 
-            const float sign = (dir == FFTDirection::Forward) ? -1.0f : +1.0f;
+        static std::uint32_t reverse_bits(std::uint32_t v) noexcept
+        {
+            v = ((v >> 1) & 0x55555555u) | ((v & 0x55555555u) << 1);
+            v = ((v >> 2) & 0x33333333u) | ((v & 0x33333333u) << 2);
+            v = ((v >> 4) & 0x0F0F0F0Fu) | ((v & 0x0F0F0F0Fu) << 4);
+            v = ((v >> 8) & 0x00FF00FFu) | ((v & 0x00FF00FFu) << 8);
+            return (v >> 16) | (v << 16);
+        }
 
-            for (std::size_t len = 2; len <= n; len <<= 1)
+        void bit_reverse_inplace() const
+        {
+            for (std::size_t i = 0; i < re_.size(); ++i)
             {
-                const float ang = sign * 2.0f * PI / static_cast<float>(len);
-                const float c0 = std::cos(ang);
-                const float s0 = std::sin(ang);
-
-                for (std::size_t i = 0; i < n; i += len)
+                const std::size_t j = bitrev_[i];
+                if (i < j)
                 {
-                    Vec2f w{1.0f, 0.0f};
-                    const std::size_t half = len >> 1;
+                    std::swap(re_[i], re_[j]);
+                    std::swap(im_[i], im_[j]);
+                }
+            }
+        }
 
-                    for (std::size_t j = 0; j < half; ++j)
-                    {
-                        Vec2f u = a[i + j];
-                        Vec2f v = cmul(a[i + j + half], w);
+        // Unscaled transform of the bit-reversed work buffers: an optional radix-2 stage followed by radix-4
+        // stages. Stages narrower than the SIMD width run on the scalar batch.
+        template <bool Inverse>
+        void butterflies() const
+        {
+            using namespace detail::simd;
 
-                        a[i + j] = cadd(u, v);
-                        a[i + j + half] = csub(u, v);
+            const std::size_t n = re_.size();
+            float* re = re_.data();
+            float* im = im_.data();
+            std::size_t q = 1;
 
-                        float wx = w.x * c0 - w.y * s0;
-                        float wy = w.x * s0 + w.y * c0;
-                        w = {wx, wy};
-                    }
+            if (std::countr_zero(n) & 1)
+            {
+                for (std::size_t i = 0; i < n; i += 2)
+                {
+                    const float ur = re[i], ui = im[i];
+                    const float vr = re[i + 1], vi = im[i + 1];
+                    re[i] = ur + vr;
+                    im[i] = ui + vi;
+                    re[i + 1] = ur - vr;
+                    im[i + 1] = ui - vi;
                 }
+                q = 2;
             }
 
-            if (dir == FFTDirection::Inverse)
+            const float* twr = tw_re_.data();
+            const float* twi = tw_im_.data();
+            for (; 4 * q <= n; q *= 4)
             {
-                const float inv = 1.0f / static_cast<float>(n);
-                for (auto& z : a) z = cscale(z, inv);
+                if (q >= Native::width)
+                    radix4_stage<Native, Inverse>(re, im, n, q, twr, twi);
+                else
+                    radix4_stage<Scalar, Inverse>(re, im, n, q, twr, twi);
+                twr += 3 * q;
+                twi += 3 * q;
             }
         }
 
-        void fft_radix2(std::span<const Vec2f> in, std::span<Vec2f> out) const
+        void transform_bitreversed(const FFTDirection dir) const
         {
-            std::ranges::copy(in, scratch_.begin());
-            fft_radix2_inplace(scratch_, dir_);
-            std::copy_n(scratch_.begin(), n_, out.begin());
+            if (dir == FFTDirection::Forward)
+                butterflies<false>();
+            else
+                butterflies<true>();
+        }
+
+        void fft_radix2(std::span<const Vec2f> in, std::span<Vec2f> out, const float scale) const
+        {
+            // permute while splitting instead of swapping in place afterwards
+            for (std::size_t i = 0; i < n_; ++i)
+            {
+                re_[bitrev_[i]] = in[i].x;
+                im_[bitrev_[i]] = in[i].y;
+            }
+
+            transform_bitreversed(dir_);
+
+            for (std::size_t i = 0; i < n_; ++i)
+                out[i] = {re_[i] * scale, im_[i] * scale};
+        }
+
+        void fft_fixed(std::span<const Vec2f> in, const std::span<Vec2f> out, const float scale) const
+        {
+            // The kernels read strided input while writing out, so they need separate buffers
+            if (in.data() == out.data())
+            {
+                alias_.assign(in.begin(), in.end());
+                in = alias_;
+            }
+            fixed_(in.data(), out.data());
+            if (scale != 1.0f)
+            {
+                for (Vec2f& v : out)
+                    v = detail::cscale(v, scale);
+            }
         }
 
         void precompute_bluestein()
@@ -177,50 +640,98 @@ namespace fft
 
             chirp_.resize(n_);
 
-            const float s = (dir_ == FFTDirection::Forward) ? +1.0f : -1.0f;
+            // Forward uses e^{-i*pi*k^2/n} so both code paths share the e^{-2*pi*i*jk/n} convention
+            const float s = (dir_ == FFTDirection::Forward) ? -1.0f : +1.0f;
 
             for (std::size_t k = 0; k < n_; ++k)
             {
-                const float kk = static_cast<float>(k) * static_cast<float>(k);
+                // k^2 mod 2n is exact, a float k^2 loses the phase for large n
+                const auto kk = static_cast<float>((k * k) % (2 * n_));
                 const float ang = s * PI * kk / static_cast<float>(n_);
                 chirp_[k] = {std::cos(ang), std::sin(ang)};
             }
 
-            std::ranges::fill(B_, Vec2f{});
             for (std::size_t k = 0; k < n_; ++k)
             {
                 const Vec2f c = cconj(chirp_[k]);
-                B_[k] = c;
-                if (k != 0) B_[m_ - k] = c;
+                re_[bitrev_[k]] = c.x;
+                im_[bitrev_[k]] = c.y;
+                if (k != 0)
+                {
+                    re_[bitrev_[m_ - k]] = c.x;
+                    im_[bitrev_[m_ - k]] = c.y;
+                }
+            }
+
+            // The kernel only depends on n, transform it once here instead of on every execute.
+            // The 1/m of the convolution's inverse transform is folded in as well.
+            transform_bitreversed(FFTDirection::Forward);
+            const float inv_m = 1.0f / static_cast<float>(m_);
+            B_re_.resize(m_);
+            B_im_.resize(m_);
+            for (std::size_t i = 0; i < m_; ++i)
+            {
+                B_re_[i] = re_[i] * inv_m;
+                B_im_[i] = im_[i] * inv_m;
             }
         }
 
-        void fft_bluestein(const std::span<const Vec2f> in, std::span<Vec2f> out) const
+        void fft_bluestein(const std::span<const Vec2f> in, std::span<Vec2f> out, const float scale) const
         {
             using namespace detail;
 
-            // A[k] = in[k] * chirp[k]
-            std::ranges::fill(A_, Vec2f{});
+            // A[k] = in[k] * chirp[k], written to bit-reversed positions
+            std::ranges::fill(re_, 0.0f);
+            std::ranges::fill(im_, 0.0f);
             for (std::size_t k = 0; k < n_; ++k)
-                A_[k] = cmul(in[k], chirp_[k]);
+            {
+                const Vec2f a = cmul(in[k], chirp_[k]);
+                re_[bitrev_[k]] = a.x;
+                im_[bitrev_[k]] = a.y;
+            }
 
-            // Copy B to conv_
-            conv_ = B_;
+            // FFT(A), B already holds the kernel spectrum
+            transform_bitreversed(FFTDirection::Forward);
 
-            // FFT(A) and FFT(conv_)
-            fft_radix2_inplace(A_, FFTDirection::Forward);
-            fft_radix2_inplace(conv_, FFTDirection::Forward);
-
-            // pointwise multiply
-            for (std::size_t i = 0; i < m_; ++i)
-                A_[i] = cmul(A_[i], conv_[i]);
+            // pointwise multiply (m is a power of two, so only tiny sizes leave a scalar tail)
+            const std::size_t done = simd::pointwise_mul<simd::Native>(re_.data(), im_.data(),
+                                                                       B_re_.data(), B_im_.data(), m_);
+            simd::pointwise_mul<simd::Scalar>(re_.data() + done, im_.data() + done,
+                                              B_re_.data() + done, B_im_.data() + done, m_ - done);
 
             // inverse FFT
-            fft_radix2_inplace(A_, FFTDirection::Inverse);
+            bit_reverse_inplace();
+            transform_bitreversed(FFTDirection::Inverse);
 
-            // final multiply by chirp
+            // final multiply by chirp and the requested scale
             for (std::size_t k = 0; k < n_; ++k)
-                out[k] = cmul(A_[k], chirp_[k]);
+                out[k] = cscale(cmul({re_[k], im_[k]}, chirp_[k]), scale);
         }
     };
+
+    // Distinct plans a thread keeps around, enough for a few sample counts in both directions
+    inline constexpr std::size_t PLAN_CACHE_SIZE = 8;
+
+    // Plan for n and dir from a small per-thread cache, most recently used first, so switching between sizes does
+    // not rebuild tables and Bluestein kernels. Plans carry mutable work buffers, hence one cache per thread rather
+    // than one per process. The reference stays valid until PLAN_CACHE_SIZE other plans have been requested.
+    [[nodiscard]] inline const FFT& plan(const std::size_t n, const FFTDirection dir = FFTDirection::Forward)
+    {
+        thread_local std::vector<std::unique_ptr<FFT>> cache;
+
+        const auto hit = std::ranges::find_if(cache, [&](const std::unique_ptr<FFT>& p)
+        {
+            return p->size() == n && p->direction() == dir;
+        });
+        if (hit != cache.end())
+        {
+            std::rotate(cache.begin(), hit, hit + 1);
+            return *cache.front();
+        }
+
+        if (cache.empty()) cache.reserve(PLAN_CACHE_SIZE);
+        if (cache.size() == PLAN_CACHE_SIZE) cache.pop_back();
+        cache.insert(cache.begin(), std::make_unique<FFT>(n, dir));
+        return *cache.front();
+    }
 } // namespace fft
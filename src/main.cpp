@@ -9,6 +9,10 @@
 #include <algorithm>
 #include <format>
 #include <string>
+#include <memory>
+#include <stdexcept>
+#include <optional>
+#include <cstdint>
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
@@ -17,7 +21,18 @@
 #include "FourierCircles.h"
 #include "svg.h"
 #include "TextRenderer.h"
+#include "GeometryBatch.h"
+#include "EpicycleMesh.h"
+#include "RetainedLayer.h"
+#include "ContourCache.h"
+#include "LiveDrawing.h"
+#include "SvgLoader.h"
+#include "FrameProfiler.h"
+#include "FrameExporter.h"
+#include "Scene.h"
+#include "ThreadPool.h"
 #include "embedded_svg.h"
+#include "embedded_coefficients.h"
 
 using geometry::Vec2f;
 
@@ -31,11 +46,30 @@ constexpr float PI_F = std::numbers::pi_v<float>;
 constexpr int INITIAL_WINDOW_W = 2560;
 constexpr int INITIAL_WINDOW_H = 1440;
 constexpr float SIMULATION_PERIOD = 60.0f; // Seconds for one full cycle
-constexpr size_t CONTOUR_SAMPLES = 2000;
-constexpr size_t CONTOUR_CACHE_RESERVE = static_cast<size_t>(CONTOUR_SAMPLES) + 2u;
-constexpr size_t SVG_SAMPLE_COUNT = 100;
-constexpr float SVG_INITIAL_OFFSET_X = 100.0f;
-constexpr float SVG_INITIAL_SCALE = 1.5f;
+constexpr float SIMULATION_TICK = 1.0f / 240.0f; // Seconds per fixed time step, lets the vectors be phasor-stepped
+constexpr size_t CONTOUR_SAMPLES_MIN = 2048;
+constexpr size_t CONTOUR_SAMPLES_MAX = 65536;
+constexpr size_t CONTOUR_SAMPLES_PER_VECTOR = 4;
+constexpr size_t SVG_SAMPLE_COUNT = 100; // keep in sync with DEFAULT_SVG_SAMPLE_COUNT in CMakeLists.txt
+constexpr float SVG_INITIAL_OFFSET_X = 100.0f; // and DEFAULT_SVG_OFFSET_X
+constexpr float SVG_INITIAL_SCALE = 1.5f; // and DEFAULT_SVG_SCALE
+constexpr const char* APP_ORGANIZATION = "Kam1k4dze";
+constexpr const char* APP_NAME = "FourierCircles";
+constexpr const char* COEFFICIENT_CACHE_WEB_DIR = "/cache";
+constexpr const char* PROFILER_TRACE_FILE = "fourier_trace.json";
+constexpr float PROFILER_OVERLAY_REFRESH = 0.25f; // Seconds between overlay text rebuilds
+constexpr float TRAIL_FADE_TIME = 1.5f; // Seconds for the tip trail to fade to 1/e
+constexpr float TRAIL_SETTLE_TIME = TRAIL_FADE_TIME * 6.0f; // a still trail is below one 8-bit step after this
+constexpr float LIVE_SAMPLE_SPACING = 2.0f; // Screen pixels between samples of a drawn stroke
+constexpr int FRAME_RATE_CAP = 0; // Frames per second while animating, 0 follows the display
+constexpr int IDLE_RAF_INTERVAL = 6; // Web: animation frames per iteration while idle, keeps input responsive
+constexpr int GALLERY_COLUMNS = 8;
+constexpr int GALLERY_ROWS = 5;
+constexpr float GALLERY_SPACING = 1.15f; // cell size relative to the drawing's bounding box
+constexpr int EXPORT_DEFAULT_W = 3840;
+constexpr int EXPORT_DEFAULT_H = 2160;
+constexpr int EXPORT_DEFAULT_FRAMES = 3600; // frames per SIMULATION_PERIOD, 60 fps at normal speed
+constexpr int EXPORT_PROGRESS_INTERVAL = 120; // frames between progress log lines
 constexpr float ZOOM_STEP = 1.1f;
 constexpr float ZOOM_MIN = 0.01f;
 constexpr float ZOOM_MAX = 500.0f;
@@ -43,7 +77,8 @@ constexpr float MIN_DRAWABLE_RADIUS = 1.0f;
 constexpr float CIRCLE_SEGMENTS_PER_PIXEL = 3.0f;
 constexpr uint8_t CIRCLE_SEGMENTS_MIN = 16;
 constexpr uint8_t CIRCLE_SEGMENTS_MAX = 128;
-constexpr size_t CIRCLE_POINT_BUFFER_SIZE = static_cast<size_t>(CIRCLE_SEGMENTS_MAX) + 2u;
+constexpr float CIRCLE_LINE_WIDTH = 1.0f;
+constexpr float ARM_LINE_WIDTH = 1.0f;
 constexpr Uint8 CIRCLE_OUTLINE_ALPHA = 40;
 constexpr size_t MIN_ACTIVE_VECTOR_COUNT = 0;
 constexpr size_t MIN_VECTOR_STEP = 1;
@@ -77,6 +112,24 @@ constexpr SDL_Color ARM_COLORS[5] = {
     {0x10, 0xB9, 0x81, 255},
 };
 
+constexpr SDL_FColor toFColor(const SDL_Color c)
+{
+    return {c.r / 255.0f, c.g / 255.0f, c.b / 255.0f, c.a / 255.0f};
+}
+
+// Vertex colors for the batched arms
+constexpr SDL_FColor ARM_FCOLORS[5] = {
+    toFColor(ARM_COLORS[0]), toFColor(ARM_COLORS[1]), toFColor(ARM_COLORS[2]),
+    toFColor(ARM_COLORS[3]), toFColor(ARM_COLORS[4]),
+};
+
+constexpr EpicycleMesh::Style EPICYCLE_STYLE = {
+    toFColor(COLOR_CIRCLE), ARM_FCOLORS, CIRCLE_LINE_WIDTH, ARM_LINE_WIDTH, MIN_DRAWABLE_RADIUS,
+    CIRCLE_SEGMENTS_PER_PIXEL, CIRCLE_SEGMENTS_MIN, CIRCLE_SEGMENTS_MAX,
+};
+
+constexpr Scene::Style GALLERY_STYLE = {toFColor(COLOR_CONTOUR), ARM_LINE_WIDTH, EPICYCLE_STYLE};
+
 
 struct Camera
 {
@@ -105,17 +158,87 @@ struct Camera
     }
 };
 
+// Everything the UI text depends on; the text block is only rebuilt when this changes
+struct UiSnapshot
+{
+    bool dialog = false;
+    bool help = false;
+    bool loading = false;
+    std::string sample_count_text;
+    int window_w = 0;
+    int window_h = 0;
+    bool paused = false;
+    size_t active_vectors = 0;
+    size_t max_vectors = 0;
+    size_t samples = 0;
+    float zoom = 0.0f;
+    float time_scale = 0.0f;
+    size_t vector_step = 0;
+    bool follow_mode = false;
+    bool show_original_points = false;
+    bool show_trail = false;
+    bool draw_mode = false;
+    bool gallery = false;
+    size_t gallery_size = 0;
+    size_t gallery_visible = 0;
+    float font_size = 0.0f;
+
+    bool operator==(const UiSnapshot&) const = default;
+};
+
+// Everything a presented frame depends on. When it is unchanged and nothing animates, the frame on screen still
+// stands and the iteration is skipped.
+struct FrameKey
+{
+    UiSnapshot ui;
+    int window_w = 0;
+    int window_h = 0;
+    Vec2f camera;
+    float zoom = 0.0f;
+    float time = 0.0f;
+    bool show_profiler = false;
+    bool tracing = false;
+
+    bool operator==(const FrameKey&) const = default;
+};
+
+// Offline rendering: the whole period at a fixed frame count into an offscreen target, no window interaction
+struct ExportState
+{
+    std::unique_ptr<FrameExporter> writer; // null when running interactively
+    SDL_Texture* target = nullptr;
+    int frame = 0;
+    int frames = 0;
+    std::chrono::steady_clock::time_point started;
+};
+
+// Cached cutoff between individually drawn and collapsed epicycles
+struct ArmLod
+{
+    float zoom = 0.0f;
+    size_t count = 0;
+    size_t cutoff = 0;
+};
+
 struct AppState
 {
     SDL_Window* window = nullptr;
     SDL_Renderer* renderer = nullptr;
 
     FourierCircles fc;
+    SvgLoader loader{
+        default_svg_content, std::as_bytes(embedded_coefficients), SVG_INITIAL_OFFSET_X, SVG_INITIAL_SCALE
+    };
     std::vector<Vec2f> original_points;
-    std::vector<Vec2f> contour_cache;
+    ContourCache contour;
+    RetainedLayer contourLayer;
+    LiveDrawing live;
+    bool draw_mode = false; // left drag draws a stroke instead of panning
 
     std::chrono::steady_clock::time_point last_tick;
     float accumulated_time = 0.0f;
+    float unsimulated_time = 0.0f; // real time not yet consumed by a whole tick
+    float frame_time = 0.0f; // real seconds the current frame stands for
     float time_scale = 1.0f;
     bool paused = false;
 
@@ -126,10 +249,16 @@ struct AppState
 
     Camera cam;
     Vec2f current_tip = {0, 0};
+    ArmLod arm_lod;
 
     bool show_ui = true;
     bool show_original_points = false;
     bool show_sample_count_prompt = false;
+    bool show_trail = false;
+    RetainedLayer trailLayer;
+    std::uint64_t trail_version = 0; // bumped to wipe the trail
+    std::optional<Vec2f> trail_last; // tip position the trail was last extended to
+    float trail_still_time = 0.0f; // seconds the tip has not moved, while the trail keeps fading
     std::string sample_count_text;
 
     std::string current_svg_path;
@@ -140,8 +269,25 @@ struct AppState
     Vec2f cam_start = {0, 0};
 
     TextRenderer textRenderer;
+    TextRenderer::TextBlock uiText;
+    UiSnapshot uiSnapshot;
+    GeometryBatch epicycleBatch;
+    EpicycleMesh epicycleMesh{EPICYCLE_STYLE};
+    ThreadPool pool;
+    Scene gallery{GALLERY_STYLE};
+    bool show_gallery = false;
+    FrameProfiler profiler;
+    bool show_profiler = false;
+    TextRenderer::TextBlock profilerText;
+    std::chrono::steady_clock::time_point profilerTextTime;
     float currentDpiScale = 1.0f;
     float currentFontSize = BASE_UI_FONT_SIZE;
+
+    ExportState exporting;
+
+    FrameKey presented; // state of the frame on screen
+    bool force_redraw = true; // the window contents were lost or are stale regardless of the key
+    std::optional<bool> idle; // whether iterations are paced by input instead of the display, unset until the first
 };
 
 
@@ -156,66 +302,114 @@ SDL_FPoint* as_sdl_fpoints(Vec2f* v)
     return reinterpret_cast<SDL_FPoint*>(v);
 }
 
+const SDL_FPoint* as_sdl_fpoints(const Vec2f* v)
+{
+    return as_sdl_fpoints(const_cast<Vec2f*>(v));
+}
+
+// Starts loading in the background; the current drawing stays up until applyLoadedSVG swaps the result in
 void loadSVG(AppState* app, const std::string& path, const int sample_count)
 {
-    if (path.empty())
+    app->loader.request(path, sample_count);
+}
+
+// Fills the gallery with copies of the current drawing in a grid centered on the world origin, each running a
+// little ahead of the previous one. Returns the world size of the wall.
+Vec2f buildGallery(AppState* app)
+{
+    app->gallery.clear();
+    if (app->original_points.empty()) return {0.0f, 0.0f};
+
+    Vec2f lo = app->original_points.front();
+    Vec2f hi = lo;
+    for (const Vec2f& p : app->original_points)
     {
-        app->original_points = svg::readSVGCurveFromString(default_svg_content, sample_count);
+        lo = {std::min(lo.x, p.x), std::min(lo.y, p.y)};
+        hi = {std::max(hi.x, p.x), std::max(hi.y, p.y)};
     }
-    else
+    const Vec2f center = (lo + hi) / 2.0f;
+    const Vec2f cell = (hi - lo) * GALLERY_SPACING;
+
+    constexpr int count = GALLERY_COLUMNS * GALLERY_ROWS;
+    for (int i = 0; i < count; ++i)
     {
-        app->original_points = svg::readSVGCurveFromFile(path, sample_count);
+        const float column = static_cast<float>(i % GALLERY_COLUMNS) - (GALLERY_COLUMNS - 1) / 2.0f;
+        const float row = static_cast<float>(i / GALLERY_COLUMNS) - (GALLERY_ROWS - 1) / 2.0f;
+        const Vec2f position = Vec2f(column * cell.x, row * cell.y) - center;
+        app->gallery.add(app->fc, position, 1.0f, static_cast<float>(i) / count);
     }
-    const bool failed = std::all_of(app->original_points.begin(), app->original_points.end(),
-                                    [](const Vec2f& p) { return p == Vec2f{0.0f, 0.0f}; });
+    return {cell.x * GALLERY_COLUMNS, cell.y * GALLERY_ROWS};
+}
 
-    if (failed)
+void toggleGallery(AppState* app)
+{
+    app->show_gallery = !app->show_gallery;
+    if (!app->show_gallery)
     {
-        SDL_Log("Failed to load SVG from file: %s, using embedded default", path.c_str());
-        // Fall back to embedded SVG
-        app->original_points = svg::readSVGCurveFromString(default_svg_content, sample_count);
+        app->gallery.clear();
+        return;
     }
 
-    for (auto& point : app->original_points)
+    const Vec2f wall = buildGallery(app);
+    app->cam.follow_mode = false;
+
+    // Fit the whole wall into the window
+    int w, h;
+    SDL_GetWindowSize(app->window, &w, &h);
+    const float zoom = std::min(static_cast<float>(w) / std::max(wall.x, 1.0f),
+                                static_cast<float>(h) / std::max(wall.y, 1.0f));
+    app->cam.zoom = std::clamp(zoom, ZOOM_MIN, ZOOM_MAX);
+    app->cam.position = {w / 2.0f, h / 2.0f};
+}
+
+void applyLoadedSVG(AppState* app, SvgLoader::Result&& loaded)
+{
+#ifdef __EMSCRIPTEN__
+    // Persist the new cache snapshot from MEMFS to IndexedDB
+    if (loaded.cacheWritten)
     {
-        point.x += SVG_INITIAL_OFFSET_X;
-        point *= SVG_INITIAL_SCALE;
+        EM_ASM(FS.syncfs(false, function(err) { if (err) console.warn('Cache sync failed', err); }););
     }
+#endif
 
-    app->fc.calculateCoefficients(app->original_points);
+    app->original_points = std::move(loaded.points);
+    app->fc = std::move(loaded.circles);
 
-    app->max_vectors = sample_count;
+    app->max_vectors = loaded.sampleCount;
     app->active_vectors = app->max_vectors;
     app->dirty_contour = true;
+    app->arm_lod = {};
+    ++app->trail_version;
 
-    app->current_svg_path = path;
-    app->svg_sample_count = sample_count;
+    app->current_svg_path = std::move(loaded.path);
+    app->svg_sample_count = loaded.sampleCount;
     app->accumulated_time = 0.0f;
+
+    if (app->show_gallery) buildGallery(app);
 }
 
+// Puts the window of the stroke being drawn up as the current drawing
+void applyLiveDrawing(AppState* app)
+{
+    const auto points = app->live.points();
+    app->original_points.assign(points.begin(), points.end());
+    app->fc.setCoefficients(app->live.coefficients());
+
+    app->max_vectors = LiveDrawing::WINDOW;
+    app->active_vectors = std::min(app->active_vectors, app->max_vectors);
+    app->dirty_contour = true;
+    app->arm_lod = {};
+}
 
 void regenerateContour(AppState* app)
 {
-    app->contour_cache.clear();
-    app->contour_cache.reserve(CONTOUR_CACHE_RESERVE);
-
     const size_t count = std::min(app->active_vectors, app->max_vectors);
 
-    // We simply iterate t from 0 to 1
-    for (int i = 0; i <= CONTOUR_SAMPLES; i++)
-    {
-        const float t = static_cast<float>(i) / static_cast<float>(CONTOUR_SAMPLES);
-        app->fc.calculateVectors(t);
-        const auto& vectors = app->fc.getVectors();
-
-        Vec2f accumulator = {0.f, 0.f};
-        // Sum active vectors
-        for (size_t v = 0; v < count && v < vectors.size(); ++v)
-        {
-            accumulator += vectors[v];
-        }
-        app->contour_cache.emplace_back(accumulator.x, accumulator.y);
-    }
+    // Coarse resolution grows with the spectrum; the inverse FFT keeps this O(M log M) regardless of count.
+    // Finer levels are added by the cache as the camera zooms in.
+    const size_t samples = std::clamp(app->max_vectors * CONTOUR_SAMPLES_PER_VECTOR,
+                                      CONTOUR_SAMPLES_MIN, CONTOUR_SAMPLES_MAX);
+    app->contour.build(app->fc, count, samples);
 
     app->dirty_contour = false;
 }
@@ -230,123 +424,270 @@ void setActiveVectors(AppState* app, const size_t target)
     app->dirty_contour = true;
 }
 
-// Draw a circle with LOD based on zoom level
-void drawCircle(SDL_Renderer* renderer, const Vec2f center, const float radius_screen)
+UiSnapshot captureUi(const AppState* app, const int w, const int h)
 {
-    if (radius_screen < MIN_DRAWABLE_RADIUS) return;
-
-    const auto segments = std::clamp(
-        static_cast<decltype(CIRCLE_SEGMENTS_MIN)>(radius_screen * CIRCLE_SEGMENTS_PER_PIXEL),
-        CIRCLE_SEGMENTS_MIN, CIRCLE_SEGMENTS_MAX);
-
-    static std::vector<Vec2f> points;
-    if (points.size() < segments + 1) points.resize(CIRCLE_POINT_BUFFER_SIZE);
-
-    for (int i = 0; i <= segments; ++i)
+    UiSnapshot ui;
+    ui.font_size = app->currentFontSize;
+    ui.dialog = app->show_sample_count_prompt;
+    if (ui.dialog)
     {
-        const float theta = 2.0f * PI_F * static_cast<float>(i) / static_cast<float>(segments);
-        points[i] = {
-            center.x + radius_screen * std::cos(theta),
-            center.y + radius_screen * std::sin(theta)
-        };
+        ui.sample_count_text = app->sample_count_text;
+        ui.window_w = w;
+        ui.window_h = h;
+        return ui;
     }
 
-    SDL_SetRenderDrawColor(renderer, COLOR_CIRCLE.r, COLOR_CIRCLE.g, COLOR_CIRCLE.b, COLOR_CIRCLE.a);
-    SDL_RenderLines(renderer, as_sdl_fpoints(points.data()), segments + 1);
+    ui.help = app->show_ui;
+    ui.loading = app->loader.busy();
+    ui.paused = app->paused;
+    ui.active_vectors = app->active_vectors;
+    ui.max_vectors = app->max_vectors;
+    ui.samples = app->original_points.size();
+    ui.zoom = app->cam.zoom;
+    ui.time_scale = app->time_scale;
+    ui.vector_step = app->vector_step;
+    ui.follow_mode = app->cam.follow_mode;
+    ui.show_original_points = app->show_original_points;
+    ui.show_trail = app->show_trail;
+    ui.draw_mode = app->draw_mode;
+    ui.gallery = app->show_gallery;
+    if (ui.gallery)
+    {
+        ui.gallery_size = app->gallery.size();
+        ui.gallery_visible = app->gallery.visibleCount();
+    }
+    return ui;
 }
 
-
-void drawUI(AppState* app)
+FrameKey captureFrame(const AppState* app)
 {
-    if (!app->show_ui && !app->show_sample_count_prompt) return;
-
-    int w, h;
-    SDL_GetWindowSize(app->window, &w, &h);
-
-    if (app->show_sample_count_prompt)
-    {
-        SDL_SetRenderDrawColor(app->renderer, COLOR_DIALOG_OVERLAY.r, COLOR_DIALOG_OVERLAY.g,
-                               COLOR_DIALOG_OVERLAY.b, COLOR_DIALOG_OVERLAY.a);
-        SDL_FRect overlay = {0, 0, static_cast<float>(w), static_cast<float>(h)};
-        SDL_RenderFillRect(app->renderer, &overlay);
-
-        SDL_SetTextureColorMod(app->textRenderer.m_atlasTexture, COLOR_UI_TEXT.r, COLOR_UI_TEXT.g, COLOR_UI_TEXT.b);
-
-        float dialog_x = static_cast<float>(w) / 2.0f - 200.0f;
-        float dialog_y = static_cast<float>(h) / 2.0f - 60.0f;
-        float dialog_spacing = app->currentFontSize * UI_LINE_SPACING_MULTIPLIER;
-
-        auto printDialogLine = [&](const std::string& text)
-        {
-            app->textRenderer.renderText(dialog_x, dialog_y, text);
-            dialog_y += dialog_spacing;
-        };
-
-        printDialogLine("SAMPLE COUNT");
-        printDialogLine("");
-        printDialogLine("Enter number of points (1-10000):");
-        printDialogLine(std::format("> {}_", app->sample_count_text));
-        printDialogLine("");
-        printDialogLine("[Enter] Confirm  |  [Esc] Cancel");
-
-        return; // Don't show regular UI when dialog is active
-    }
+    FrameKey key;
+    SDL_GetWindowSize(app->window, &key.window_w, &key.window_h);
+    key.ui = captureUi(app, key.window_w, key.window_h);
+    key.camera = app->cam.position;
+    key.zoom = app->cam.zoom;
+    key.time = app->accumulated_time;
+    key.show_profiler = app->show_profiler;
+    key.tracing = app->profiler.tracing();
+    return key;
+}
 
-    if (!app->show_ui) return;
+// Whether the next frame differs from the last one even with no input: the simulation runs, or some work is spread
+// over frames
+bool animating(const AppState* app)
+{
+    if (!app->paused || app->loader.busy() || app->live.changed()) return true;
+    if (app->show_gallery) return false;
+    return app->contour.refining() || (app->show_trail && app->trail_still_time < TRAIL_SETTLE_TIME);
+}
 
-    SDL_SetTextureColorMod(app->textRenderer.m_atlasTexture, COLOR_UI_TEXT.r, COLOR_UI_TEXT.g, COLOR_UI_TEXT.b);
+// Idle iterations wait for input (desktop) or run on a throttled requestAnimationFrame (web), otherwise they follow
+// the display or FRAME_RATE_CAP
+void setIdle(AppState* app, const bool idle)
+{
+    if (idle == app->idle) return;
+    app->idle = idle;
+#ifdef __EMSCRIPTEN__
+    if (idle) emscripten_set_main_loop_timing(EM_TIMING_RAF, IDLE_RAF_INTERVAL);
+    else if (FRAME_RATE_CAP > 0) emscripten_set_main_loop_timing(EM_TIMING_SETTIMEOUT, 1000 / FRAME_RATE_CAP);
+    else emscripten_set_main_loop_timing(EM_TIMING_RAF, 1);
+#else
+    SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, idle ? "waitevent" : std::to_string(FRAME_RATE_CAP).c_str());
+#endif
+}
 
-    float y = UI_MARGIN_Y;
-    float x = UI_MARGIN_X;
-    float spacing = app->currentFontSize * UI_LINE_SPACING_MULTIPLIER;
+// Makes an idle loop iterate once, for state changed outside of SDL_AppEvent
+void wakeMainLoop()
+{
+    SDL_Event event{};
+    event.type = SDL_EVENT_USER;
+    SDL_PushEvent(&event);
+}
 
-    auto printLine = [&](const std::string& text)
-    {
-        app->textRenderer.renderText(x, y, text);
-        y += spacing;
+std::vector<std::string> dialogLines(const UiSnapshot& ui)
+{
+    return {
+        "SAMPLE COUNT",
+        "",
+        "Enter number of points (1-10000):",
+        std::format("> {}_", ui.sample_count_text),
+        "",
+        "[Enter] Confirm  |  [Esc] Cancel",
     };
+}
+
+std::vector<std::string> helpLines(const UiSnapshot& ui)
+{
+    std::vector<std::string> lines;
+    auto printLine = [&](std::string text) { lines.push_back(std::move(text)); };
 
     printLine("FOURIER CIRCLES by Kam1k4dze");
     printLine("");
 
-    std::string status = app->paused ? "PAUSED" : "RUNNING";
+    std::string status = ui.loading ? "LOADING..." : ui.paused ? "PAUSED" : "RUNNING";
     printLine(std::format("Status: {}", status));
-    printLine(std::format("Active: {} / {} vectors", app->active_vectors, app->max_vectors));
-    printLine(std::format("Samples: {}", app->original_points.size()));
-    printLine(std::format("Zoom: {:.2f}x", app->cam.zoom));
-    printLine(std::format("Speed: {:.1f}x", app->time_scale));
+    printLine(std::format("Active: {} / {} vectors", ui.active_vectors, ui.max_vectors));
+    printLine(std::format("Samples: {}", ui.samples));
+    printLine(std::format("Zoom: {:.2f}x", ui.zoom));
+    printLine(std::format("Speed: {:.1f}x", ui.time_scale));
+    if (ui.gallery) printLine(std::format("Gallery: {} / {} visible", ui.gallery_visible, ui.gallery_size));
     printLine("");
 
     printLine("FILE:");
     printLine("  [L] Load SVG file");
     printLine("  [S] Change sample count");
+    printLine(std::format("  [D] Draw with the mouse: {}", ui.draw_mode ? "On" : "Off"));
     printLine("");
 
     printLine("ANIMATION:");
-    std::string pause_action = app->paused ? "Resume" : "Pause";
+    std::string pause_action = ui.paused ? "Resume" : "Pause";
     printLine(std::format("  [Space] {}", pause_action));
     printLine("  [Left/Right] Adjust speed");
     printLine("");
 
     printLine("VECTORS:");
-    std::string vector_word = app->vector_step == 1 ? "vector" : "vectors";
-    printLine(std::format("  [Up/Down] +/- {} {}", app->vector_step, vector_word));
+    std::string vector_word = ui.vector_step == 1 ? "vector" : "vectors";
+    printLine(std::format("  [Up/Down] +/- {} {}", ui.vector_step, vector_word));
     printLine("  [Ctrl+Up] Maximum");
     printLine("  [Ctrl+Down] Minimum");
-    printLine(std::format("  [,/.] Adjust step: {}", app->vector_step));
+    printLine(std::format("  [,/.] Adjust step: {}", ui.vector_step));
     printLine("");
 
     printLine("CAMERA:");
-    std::string follow_state = app->cam.follow_mode ? "Free camera" : "Follow tip";
+    std::string follow_state = ui.follow_mode ? "Free camera" : "Follow tip";
     printLine(std::format("  [F] {} (toggle)", follow_state));
-    printLine("  [Drag] Pan view");
+    printLine(ui.draw_mode ? "  [Drag] Draw" : "  [Drag] Pan view");
     printLine("  [Wheel] Zoom");
     printLine("");
 
     printLine("DISPLAY:");
-    std::string points_action = app->show_original_points ? "Hide" : "Show";
+    std::string points_action = ui.show_original_points ? "Hide" : "Show";
     printLine(std::format("  [P] {} sample points", points_action));
+    printLine(std::format("  [E] {} tip trail", ui.show_trail ? "Hide" : "Show"));
+    printLine(std::format("  [G] {} gallery wall", ui.gallery ? "Hide" : "Show"));
     printLine("  [H] Hide help");
+    printLine("  [T] Frame timings");
+    printLine("  [R] Record trace (start/stop)");
+    return lines;
+}
+
+void drawUI(AppState* app)
+{
+    if (!app->show_ui && !app->show_sample_count_prompt && !app->loader.busy()) return;
+
+    int w, h;
+    SDL_GetWindowSize(app->window, &w, &h);
+
+    if (app->show_sample_count_prompt)
+    {
+        SDL_SetRenderDrawColor(app->renderer, COLOR_DIALOG_OVERLAY.r, COLOR_DIALOG_OVERLAY.g,
+                               COLOR_DIALOG_OVERLAY.b, COLOR_DIALOG_OVERLAY.a);
+        SDL_FRect overlay = {0, 0, static_cast<float>(w), static_cast<float>(h)};
+        SDL_RenderFillRect(app->renderer, &overlay);
+    }
+
+    // Formatting and glyph layout only happen when a displayed value changed or the atlas was rebuilt
+    UiSnapshot ui = captureUi(app, w, h);
+    if (!app->textRenderer.isCurrent(app->uiText) || ui != app->uiSnapshot)
+    {
+        const float spacing = app->currentFontSize * UI_LINE_SPACING_MULTIPLIER;
+        if (ui.dialog)
+        {
+            // Don't show regular UI when dialog is active
+            const float dialog_x = static_cast<float>(w) / 2.0f - 200.0f;
+            const float dialog_y = static_cast<float>(h) / 2.0f - 60.0f;
+            app->textRenderer.buildTextBlock(app->uiText, dialog_x, dialog_y, spacing, dialogLines(ui),
+                                             toFColor(COLOR_UI_TEXT));
+        }
+        else
+        {
+            // With the help hidden only the loading notice is shown
+            const std::vector<std::string> lines = ui.help ? helpLines(ui) : std::vector<std::string>{"LOADING..."};
+            app->textRenderer.buildTextBlock(app->uiText, UI_MARGIN_X, UI_MARGIN_Y, spacing, lines,
+                                             toFColor(COLOR_UI_TEXT));
+        }
+        app->uiSnapshot = std::move(ui);
+    }
+
+    app->textRenderer.renderTextBlock(app->uiText);
+    if (!app->uiText.indices.empty()) app->profiler.countDraw(app->uiText.vertices.size());
+}
+
+std::vector<std::string> profilerLines(const FrameProfiler& profiler)
+{
+    std::vector<std::string> lines;
+    lines.push_back(std::format("{:<14}{:>8}{:>8}", "ZONE (ms)", "MEAN", "P99"));
+    for (const auto& [name, mean, p99] : profiler.stats())
+    {
+        lines.push_back(std::format("{:<14}{:>8.2f}{:>8.2f}", name, mean, p99));
+    }
+    lines.push_back("");
+    lines.push_back(std::format("Draw calls: {:.0f}", profiler.meanDrawCalls()));
+    lines.push_back(std::format("Vertices: {:.0f}", profiler.meanVertices()));
+    if (profiler.tracing()) lines.push_back("RECORDING TRACE");
+    return lines;
+}
+
+// Rolling frame timings in the top right corner; the text is refreshed a few times a second to stay readable
+void drawProfiler(AppState* app)
+{
+    if (!app->show_profiler) return;
+
+    const auto now = std::chrono::steady_clock::now();
+    if (!app->textRenderer.isCurrent(app->profilerText) ||
+        std::chrono::duration<float>(now - app->profilerTextTime).count() >= PROFILER_OVERLAY_REFRESH)
+    {
+        int w, h;
+        SDL_GetWindowSize(app->window, &w, &h);
+
+        const std::vector<std::string> lines = profilerLines(app->profiler);
+        float width = 0.0f;
+        for (const auto& line : lines) width = std::max(width, app->textRenderer.measureText(line).x);
+
+        const float spacing = app->currentFontSize * UI_LINE_SPACING_MULTIPLIER;
+        app->textRenderer.buildTextBlock(app->profilerText, static_cast<float>(w) - width - UI_MARGIN_X,
+                                         UI_MARGIN_Y, spacing, lines, toFColor(COLOR_UI_TEXT));
+        app->profilerTextTime = now;
+    }
+
+    app->textRenderer.renderTextBlock(app->profilerText);
+    if (!app->profilerText.indices.empty()) app->profiler.countDraw(app->profilerText.vertices.size());
+}
+
+void toggleTrace(AppState* app)
+{
+    if (!app->profiler.tracing())
+    {
+        app->profiler.startTrace();
+        SDL_Log("Recording frame trace");
+        return;
+    }
+
+#ifdef __EMSCRIPTEN__
+    const std::string path = std::string("/tmp/") + PROFILER_TRACE_FILE;
+#else
+    char* pref = SDL_GetPrefPath(APP_ORGANIZATION, APP_NAME);
+    const std::string path = (pref ? std::string(pref) : std::string()) + PROFILER_TRACE_FILE;
+    SDL_free(pref);
+#endif
+    if (!app->profiler.stopTrace(path))
+    {
+        SDL_Log("Failed to write trace to %s", path.c_str());
+        return;
+    }
+    SDL_Log("Frame trace written to %s", path.c_str());
+
+#ifdef __EMSCRIPTEN__
+    // Nothing outside the page can read MEMFS, hand the file to the browser as a download
+    EM_ASM({
+        const data = FS.readFile(UTF8ToString($0));
+        const link = document.createElement('a');
+        link.href = URL.createObjectURL(new Blob([data], {type: 'application/json'}));
+        link.download = UTF8ToString($1);
+        link.click();
+        setTimeout(function() { URL.revokeObjectURL(link.href); }, 0);
+    }, path.c_str(), PROFILER_TRACE_FILE);
+#endif
 }
 
 void showSampleCountPrompt(AppState* app)
@@ -368,7 +709,7 @@ void processSampleCountInput(AppState* app)
         }
 
         loadSVG(app, app->current_svg_path, sample_count);
-        SDL_Log("Loaded SVG with %d samples", sample_count);
+        SDL_Log("Loading SVG with %d samples", sample_count);
     }
     catch (const std::exception& e)
     {
@@ -435,6 +776,7 @@ void fileDialogCallback(void* userdata, const char* const* filelist, int filter)
     app->current_svg_path = filelist[0];
 
     showSampleCountPrompt(app);
+    wakeMainLoop(); // the callback may run on another thread while the loop waits for input
 
     SDL_Log("Selected file: %s", filelist[0]);
 }
@@ -474,11 +816,118 @@ void updateDpiScale(AppState* app)
 }
 
 
+// Where loaded drawings are cached: the user's pref path on desktop, an IndexedDB-backed mount on the web
+std::string coefficientCacheDirectory()
+{
+#ifdef __EMSCRIPTEN__
+    EM_ASM(
+        FS.mkdir(UTF8ToString($0));
+        FS.mount(IDBFS, {}, UTF8ToString($0));
+        FS.syncfs(true, function(err) { if (err) console.warn('Cache restore failed', err); });
+    , COEFFICIENT_CACHE_WEB_DIR);
+    return COEFFICIENT_CACHE_WEB_DIR;
+#else
+    char* pref = SDL_GetPrefPath(APP_ORGANIZATION, APP_NAME);
+    if (!pref)
+    {
+        SDL_Log("No pref path, coefficient cache disabled: %s", SDL_GetError());
+        return {};
+    }
+    std::string directory = std::string(pref) + "cache";
+    SDL_free(pref);
+    return directory;
+#endif
+}
+
+struct ExportOptions
+{
+    std::string target; // empty: interactive
+    std::string svg_path; // empty: the embedded default
+    int width = EXPORT_DEFAULT_W;
+    int height = EXPORT_DEFAULT_H;
+    int frames = EXPORT_DEFAULT_FRAMES;
+    int samples = SVG_SAMPLE_COUNT;
+};
+
+// FourierCircles --export <directory|-> [--size WxH] [--frames N] [--samples N] [file.svg]
+// Without --export the arguments are left alone and the app starts interactively as usual.
+bool parseExportArguments(const int argc, char** argv, ExportOptions& options)
+{
+    if (std::none_of(argv + 1, argv + argc, [](const char* arg) { return std::string_view(arg) == "--export"; }))
+    {
+        return true;
+    }
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const bool has_value = i + 1 < argc;
+            if (arg == "--export" && has_value) options.target = argv[++i];
+            else if (arg == "--frames" && has_value) options.frames = std::stoi(argv[++i]);
+            else if (arg == "--samples" && has_value) options.samples = std::stoi(argv[++i]);
+            else if (arg == "--size" && has_value)
+            {
+                const std::string size = argv[++i];
+                const size_t x = size.find('x');
+                if (x == std::string::npos) throw std::invalid_argument("size must be WxH");
+                options.width = std::stoi(size.substr(0, x));
+                options.height = std::stoi(size.substr(x + 1));
+            }
+            else if (!arg.starts_with("--")) options.svg_path = arg;
+            else throw std::invalid_argument("unknown option " + arg);
+        }
+        if (options.width < 1 || options.height < 1 || options.frames < 1 ||
+            options.samples < 1 || options.samples > 10000)
+        {
+            throw std::invalid_argument("size, frames and samples must be positive, samples at most 10000");
+        }
+    }
+    catch (const std::exception& e)
+    {
+        SDL_Log("Invalid arguments: %s", e.what());
+        SDL_Log("Usage: %s --export <directory|-> [--size WxH] [--frames N] [--samples N] [file.svg]", argv[0]);
+        return false;
+    }
+    return true;
+}
+
+SDL_AppResult startExport(AppState* app, const ExportOptions& options)
+{
+    ExportState& ex = app->exporting;
+    ex.target = SDL_CreateTexture(app->renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET,
+                                  options.width, options.height);
+    if (!ex.target)
+    {
+        SDL_Log("Cannot create a %dx%d render target: %s", options.width, options.height, SDL_GetError());
+        return SDL_APP_FAILURE;
+    }
+
+    auto writer = std::make_unique<FrameExporter>(options.target, options.width, options.height);
+    if (!writer->open()) return SDL_APP_FAILURE;
+    ex.writer = std::move(writer);
+    ex.frames = options.frames;
+
+    // Same framing as the default window, scaled to the output height
+    app->cam.zoom = static_cast<float>(options.height) / INITIAL_WINDOW_H;
+    app->cam.position = {options.width / 2.0f, options.height / 2.0f};
+
+    loadSVG(app, options.svg_path, options.samples);
+    SDL_Log("Exporting %d frames at %dx%d to %s", options.frames, options.width, options.height,
+            ex.writer->streaming() ? "stdout (raw RGBA)" : options.target.c_str());
+    return SDL_APP_CONTINUE;
+}
+
 SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv)
 {
     auto* app = new AppState();
     *appstate = app;
 
+    ExportOptions export_options;
+    if (!IS_EMSCRIPTEN && !parseExportArguments(argc, argv, export_options)) return SDL_APP_FAILURE;
+    const bool exporting = !export_options.target.empty();
+
     if (!SDL_Init(SDL_INIT_VIDEO)) return SDL_APP_FAILURE;
 
     SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 1);
@@ -488,13 +937,15 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv)
     SDL_SetHint(SDL_HINT_RENDER_LINE_METHOD, "3");
 
     if (!SDL_CreateWindowAndRenderer("Fourier Circles", INITIAL_WINDOW_W, INITIAL_WINDOW_H,
-                                     SDL_WINDOW_RESIZABLE | SDL_WINDOW_HIGH_PIXEL_DENSITY, &app->window,
-                                     &app->renderer))
+                                     exporting ? SDL_WINDOW_HIDDEN
+                                               : SDL_WINDOW_RESIZABLE | SDL_WINDOW_HIGH_PIXEL_DENSITY,
+                                     &app->window, &app->renderer))
     {
         return SDL_APP_FAILURE;
     }
 
-    SDL_SetRenderVSync(app->renderer, 1);
+    // Offline frames are paced by the renderer and the writer, not the display
+    SDL_SetRenderVSync(app->renderer, exporting ? 0 : 1);
 
     SDL_SetRenderDrawBlendMode(app->renderer, SDL_BLENDMODE_BLEND);
 
@@ -508,6 +959,9 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv)
         SDL_Log("Failed to initialize text renderer");
         return SDL_APP_FAILURE;
     }
+    app->loader.setCacheDirectory(coefficientCacheDirectory());
+    if (exporting) return startExport(app, export_options);
+
     // SDL_Log("Loading embedded default SVG");
     loadSVG(app, {}, SVG_SAMPLE_COUNT);
 
@@ -520,6 +974,7 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv)
 SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event)
 {
     auto* app = static_cast<AppState*>(appstate);
+    if (app->exporting.writer && event->type != SDL_EVENT_QUIT) return SDL_APP_CONTINUE;
 
     switch (event->type)
     {
@@ -579,7 +1034,16 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event)
             }
 
             if (event->key.key == SDLK_P) app->show_original_points = !app->show_original_points;
+            if (event->key.key == SDLK_G) toggleGallery(app);
+            if (event->key.key == SDLK_E) app->show_trail = !app->show_trail;
+            if (event->key.key == SDLK_D)
+            {
+                app->draw_mode = !app->draw_mode;
+                if (!app->draw_mode) app->live.finish();
+            }
             if (event->key.key == SDLK_H) app->show_ui = !app->show_ui;
+            if (event->key.key == SDLK_T) app->show_profiler = !app->show_profiler;
+            if (event->key.key == SDLK_R) toggleTrace(app);
 
             if (event->key.key == SDLK_UP)
             {
@@ -636,7 +1100,15 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event)
         }
 
     case SDL_EVENT_MOUSE_BUTTON_DOWN:
-        if (event->button.button == SDL_BUTTON_LEFT)
+        if (event->button.button == SDL_BUTTON_LEFT && app->draw_mode && !app->show_gallery)
+        {
+            app->live.begin(app->cam.screenToWorld(event->button.x, event->button.y),
+                            LIVE_SAMPLE_SPACING / app->cam.zoom);
+            app->cam.follow_mode = false;
+            app->active_vectors = LiveDrawing::WINDOW;
+            ++app->trail_version;
+        }
+        else if (event->button.button == SDL_BUTTON_LEFT)
         {
             app->is_dragging = true;
             app->drag_start = {event->button.x, event->button.y};
@@ -646,11 +1118,19 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event)
         break;
 
     case SDL_EVENT_MOUSE_BUTTON_UP:
-        if (event->button.button == SDL_BUTTON_LEFT) app->is_dragging = false;
+        if (event->button.button == SDL_BUTTON_LEFT)
+        {
+            app->is_dragging = false;
+            app->live.finish();
+        }
         break;
 
     case SDL_EVENT_MOUSE_MOTION:
-        if (app->is_dragging)
+        if (app->live.active())
+        {
+            app->live.extend(app->cam.screenToWorld(event->motion.x, event->motion.y));
+        }
+        else if (app->is_dragging)
         {
             app->cam.position = app->cam_start +
                 Vec2f(event->motion.x, event->motion.y) - app->drag_start;
@@ -675,115 +1155,342 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event)
         updateDpiScale(app);
         break;
 
+    case SDL_EVENT_WINDOW_EXPOSED:
+        app->force_redraw = true;
+        break;
+
+    case SDL_EVENT_RENDER_TARGETS_RESET:
+    case SDL_EVENT_RENDER_DEVICE_RESET:
+        app->contourLayer.invalidate();
+        app->trailLayer.invalidate();
+        app->force_redraw = true;
+        break;
+
     default:
         break;
     }
     return SDL_APP_CONTINUE;
 }
 
-SDL_AppResult SDL_AppIterate(void* appstate)
+// Brings the contour and the vectors to periodT and sums them into the tip
+void advanceVectors(AppState* app, const float periodT, const float step, const int steps)
 {
-    auto* app = static_cast<AppState*>(appstate);
-
-    const auto now = std::chrono::steady_clock::now();
-    const float dt = std::chrono::duration<float>(now - app->last_tick).count();
-    app->last_tick = now;
+    if (app->dirty_contour)
+    {
+        FrameProfiler::Zone zone(app->profiler, "contour.build");
+        regenerateContour(app);
+    }
 
-    if (!app->paused)
     {
-        app->accumulated_time += dt * app->time_scale;
+        FrameProfiler::Zone zone(app->profiler, "vectors");
+        app->fc.stepVectors(periodT, step, steps, app->active_vectors);
     }
+    // Tip Position in World Space, summed by stepVectors
+    app->current_tip = app->fc.getResult();
+}
 
-    // Wrap time to 0..1 for calculation
-    const float periodT = std::fmod(app->accumulated_time, SIMULATION_PERIOD) / SIMULATION_PERIOD;
+// Vectors past the returned rank are shorter than MIN_DRAWABLE_RADIUS on screen. The magnitudes are sorted, so only
+// a zoom or count change moves the cutoff; it is recomputed then.
+size_t armCutoff(AppState* app, const size_t count)
+{
+    ArmLod& lod = app->arm_lod;
+    if (lod.zoom != app->cam.zoom || lod.count != count)
+    {
+        const auto sorted = app->fc.getSortedMagnitudes();
+        const auto magnitudes = sorted.first(std::min(count, sorted.size()));
+        const float threshold = MIN_DRAWABLE_RADIUS / app->cam.zoom;
+        lod.cutoff = static_cast<size_t>(std::partition_point(magnitudes.begin(), magnitudes.end(),
+                                                              [&](const float m) { return m >= threshold; }) -
+            magnitudes.begin());
+        lod.zoom = app->cam.zoom;
+        lod.count = count;
+    }
+    return lod.cutoff;
+}
 
-    if (app->dirty_contour) regenerateContour(app);
+// Tiles in view, tessellated for the current zoom, for the camera offset of the current target
+void drawContour(AppState* app, const Vec2f offset, const float width, const float height)
+{
+    app->contour.tessellate(app->fc, app->cam.zoom, offset, width, height);
+    // Exported frames are drawn fully refined, so the output does not depend on the interactive per-frame budget
+    // and the first frames of a large export are not coarser than the rest
+    while (app->exporting.writer && app->contour.refining())
+    {
+        const std::uint64_t generation = app->contour.generation();
+        app->contour.tessellate(app->fc, app->cam.zoom, offset, width, height);
+        if (app->contour.generation() == generation) break; // the budget cannot fit another grid
+    }
+    SDL_SetRenderDrawColor(app->renderer, COLOR_CONTOUR.r, COLOR_CONTOUR.g, COLOR_CONTOUR.b, COLOR_CONTOUR.a);
+    const Vec2f* points = app->contour.points().data();
+    for (const auto& [first, count] : app->contour.runs())
+    {
+        SDL_RenderLines(app->renderer, as_sdl_fpoints(points + first), static_cast<int>(count));
+        app->profiler.countDraw(count);
+    }
+}
 
-    app->fc.calculateVectors(periodT);
-    const auto& vectors = app->fc.getVectors();
+// Fading path of the tip, kept in its own layer: each frame darkens what is there and adds the newest segment
+void drawTrail(AppState* app, const int w, const int h)
+{
+    RetainedLayer& layer = app->trailLayer;
+    if (layer.prepare(app->renderer, w, h, app->cam.zoom, app->cam.position, app->trail_version))
+    {
+        app->trail_last.reset();
+    }
+    if (!layer.valid()) return;
 
+    layer.bind(app->renderer);
 
-    // Calculate Tip Position in World Space
-    Vec2f tip = {0, 0};
-    const size_t limit = std::min(app->active_vectors, vectors.size());
-    for (size_t i = 0; i < limit; ++i) tip += vectors[i];
-    app->current_tip = tip;
+    // Scales color and alpha alike, which keeps the premultiplied contents consistent
+    static const SDL_BlendMode fade_mode = SDL_ComposeCustomBlendMode(
+        SDL_BLENDFACTOR_ZERO, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+        SDL_BLENDFACTOR_ZERO, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+    const float fade = 1.0f - std::exp(-app->frame_time / TRAIL_FADE_TIME);
+    if (SDL_SetRenderDrawBlendMode(app->renderer, fade_mode))
+    {
+        SDL_SetRenderDrawColor(app->renderer, 0, 0, 0, static_cast<Uint8>(std::lround(fade * 255.0f)));
+        SDL_RenderFillRect(app->renderer, nullptr);
+    }
+    else
+    {
+        layer.clear(app->renderer); // no custom blending: only the latest segment shows
+    }
+    SDL_SetRenderDrawBlendMode(app->renderer, SDL_BLENDMODE_BLEND);
 
-    if (app->cam.follow_mode)
+    if (app->trail_last)
     {
-        int w, h;
-        SDL_GetWindowSize(app->window, &w, &h);
-        const Vec2f window_size = {static_cast<float>(w), static_cast<float>(h)};
-        app->cam.position = window_size / 2.0f - tip * app->cam.zoom;
+        const Vec2f a = *app->trail_last * app->cam.zoom + layer.drawOffset();
+        const Vec2f b = app->current_tip * app->cam.zoom + layer.drawOffset();
+        SDL_SetRenderDrawColor(app->renderer, COLOR_TIP.r, COLOR_TIP.g, COLOR_TIP.b, COLOR_TIP.a);
+        SDL_RenderLine(app->renderer, a.x, a.y, b.x, b.y);
     }
+    app->trail_still_time = app->trail_last == app->current_tip ? app->trail_still_time + app->frame_time : 0.0f;
+    app->trail_last = app->current_tip;
 
+    layer.unbind(app->renderer);
+    layer.composite(app->renderer, app->cam.position);
+    app->profiler.countDraw(4);
+}
 
+// Everything but the UI, into the current render target
+void drawScene(AppState* app)
+{
     SDL_SetRenderDrawColor(app->renderer, COLOR_BG.r, COLOR_BG.g, COLOR_BG.b, COLOR_BG.a);
     SDL_RenderClear(app->renderer);
 
-    // Draw Contour
-    SDL_SetRenderDrawColor(app->renderer, COLOR_CONTOUR.r, COLOR_CONTOUR.g, COLOR_CONTOUR.b, COLOR_CONTOUR.a);
-    if (!app->contour_cache.empty())
-    {
-        static std::vector<Vec2f> screenContour;
-        screenContour.resize(app->contour_cache.size());
+    int w, h;
+    SDL_GetCurrentRenderOutputSize(app->renderer, &w, &h);
+
+    const size_t limit = std::min(app->active_vectors, app->fc.getVectorsX().size());
 
-        for (size_t i = 0; i < app->contour_cache.size(); ++i)
+    // Draw Contour: retained in its layer, redrawn only when the view or the refinement changes
+    if (!app->contour.empty())
+    {
+        FrameProfiler::Zone zone(app->profiler, "contour.draw");
+        RetainedLayer& layer = app->contourLayer;
+        const bool cleared = layer.prepare(app->renderer, w, h, app->cam.zoom, app->cam.position,
+                                           app->contour.generation());
+        if (!layer.valid())
         {
-            screenContour[i] = app->cam.worldToScreen(
-                app->contour_cache[i].x, app->contour_cache[i].y);
+            drawContour(app, app->cam.position, static_cast<float>(w), static_cast<float>(h));
+        }
+        else
+        {
+            if (cleared || app->contour.refining())
+            {
+                layer.bind(app->renderer);
+                if (!cleared) layer.clear(app->renderer);
+                drawContour(app, layer.drawOffset(), layer.width(), layer.height());
+                layer.unbind(app->renderer);
+            }
+            layer.composite(app->renderer, app->cam.position);
+            app->profiler.countDraw(4);
         }
-
-        SDL_RenderLines(app->renderer, as_sdl_fpoints(screenContour.data()), static_cast<int>(screenContour.size()));
     }
 
+    if (app->show_trail) drawTrail(app, w, h);
+
     // Draw Sample Points
     if (app->show_original_points)
     {
-        SDL_SetRenderDrawColor(app->renderer, COLOR_SAMPLE_POINTS.r, COLOR_SAMPLE_POINTS.g,
-                               COLOR_SAMPLE_POINTS.b, COLOR_SAMPLE_POINTS.a);
-        for (const auto& p : app->original_points)
+        FrameProfiler::Zone zone(app->profiler, "points");
+        static std::vector<SDL_FRect> markers;
+        markers.resize(app->original_points.size());
+        for (size_t i = 0; i < app->original_points.size(); ++i)
         {
-            const Vec2f scr = app->cam.worldToScreen(p);
-            SDL_FRect r = {
+            const Vec2f scr = app->cam.worldToScreen(app->original_points[i]);
+            markers[i] = {
                 scr.x - ORIGINAL_POINT_MARKER_HALF_SIZE, scr.y - ORIGINAL_POINT_MARKER_HALF_SIZE,
                 ORIGINAL_POINT_MARKER_SIZE, ORIGINAL_POINT_MARKER_SIZE
             };
-            SDL_RenderFillRect(app->renderer, &r);
         }
-    }
-    // Draw Epicycles
-    Vec2f prev = {0, 0};
-    for (size_t i = 0; i < limit; ++i)
-    {
-        const Vec2f center = app->cam.worldToScreen(prev);
-        const float radius = vectors[i].length() * app->cam.zoom;
 
-        drawCircle(app->renderer, center, radius);
+        SDL_SetRenderDrawColor(app->renderer, COLOR_SAMPLE_POINTS.r, COLOR_SAMPLE_POINTS.g,
+                               COLOR_SAMPLE_POINTS.b, COLOR_SAMPLE_POINTS.a);
+        SDL_RenderFillRects(app->renderer, markers.data(), static_cast<int>(markers.size()));
+        app->profiler.countDraw(markers.size() * 4);
+    }
 
-        prev += vectors[i];
+    // Draw Epicycles: circles and vertex-colored arms share one batch, in the original per-vector order
+    {
+        FrameProfiler::Zone zone(app->profiler, "epicycles");
+        app->epicycleBatch.begin(static_cast<float>(w), static_cast<float>(h));
 
-        const Vec2f end = app->cam.worldToScreen(prev);
+        const size_t cutoff = armCutoff(app, limit);
+        const Vec2f prev = app->epicycleMesh.build(app->pool, app->fc.getVectorsX(), app->fc.getVectorsY(), cutoff,
+                                                   app->cam.zoom, app->cam.position, static_cast<float>(w),
+                                                   static_cast<float>(h), app->epicycleBatch);
 
-        // Draw arm
-        const auto& [r, g, b, a] = ARM_COLORS[i % 5];
-        SDL_SetRenderDrawColor(app->renderer, r, g, b, a);
-        SDL_RenderLine(app->renderer, center.x, center.y, end.x, end.y);
+        // The sub-pixel tail as a single residual arm from the last drawn vector to the tip
+        if (cutoff < limit)
+        {
+            app->epicycleBatch.addLine(app->cam.worldToScreen(prev), app->cam.worldToScreen(app->current_tip),
+                                       ARM_LINE_WIDTH, ARM_FCOLORS[cutoff % 5]);
+        }
+        app->epicycleBatch.draw(app->renderer);
+        if (app->epicycleBatch.vertexCount() > 0) app->profiler.countDraw(app->epicycleBatch.vertexCount());
     }
 
 
     // Highlight Tip
     SDL_SetRenderDrawColor(app->renderer, COLOR_TIP.r, COLOR_TIP.g, COLOR_TIP.b, COLOR_TIP.a);
-    const Vec2f tipScr = app->cam.worldToScreen(tip);
+    const Vec2f tipScr = app->cam.worldToScreen(app->current_tip);
     const SDL_FRect tipRect = {
         tipScr.x - TIP_MARKER_HALF_SIZE, tipScr.y - TIP_MARKER_HALF_SIZE,
         TIP_MARKER_SIZE, TIP_MARKER_SIZE
     };
     SDL_RenderFillRect(app->renderer, &tipRect);
+    app->profiler.countDraw(4);
+}
+
+// Every gallery drawing is updated on the pool and the wall goes out as one draw call
+void drawGallery(AppState* app, const float periodT, const float step, const int steps)
+{
+    SDL_SetRenderDrawColor(app->renderer, COLOR_BG.r, COLOR_BG.g, COLOR_BG.b, COLOR_BG.a);
+    SDL_RenderClear(app->renderer);
+
+    int w, h;
+    SDL_GetCurrentRenderOutputSize(app->renderer, &w, &h);
+
+    FrameProfiler::Zone zone(app->profiler, "gallery");
+    app->gallery.update(app->pool, periodT, step, steps, app->cam.zoom, app->cam.position, static_cast<float>(w),
+                        static_cast<float>(h));
+    app->gallery.draw(app->renderer);
+    if (app->gallery.vertexCount() > 0) app->profiler.countDraw(app->gallery.vertexCount());
+}
+
+// One exported frame per call, as fast as rendering and the writer allow
+SDL_AppResult iterateExport(AppState* app)
+{
+    if (auto loaded = app->loader.poll()) applyLoadedSVG(app, std::move(*loaded));
+    if (app->loader.busy())
+    {
+        SDL_Delay(1);
+        return SDL_APP_CONTINUE;
+    }
 
-    drawUI(app);
+    ExportState& ex = app->exporting;
+    if (ex.frame == 0) ex.started = std::chrono::steady_clock::now();
+    if (ex.frame == ex.frames)
+    {
+        const bool ok = ex.writer->finish();
+        const float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - ex.started).count();
+        SDL_Log("Exported %d frames in %.1f s (%.1f fps)", ex.frames, seconds, static_cast<float>(ex.frames) / seconds);
+        return ok ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    }
+
+    // t depends on the frame index alone, so every run of the same settings renders the same frames
+    const float periodT = static_cast<float>(ex.frame) / static_cast<float>(ex.frames);
+    app->frame_time = SIMULATION_PERIOD / static_cast<float>(ex.frames);
+    advanceVectors(app, periodT, 1.0f / static_cast<float>(ex.frames), ex.frame == 0 ? 0 : 1);
+
+    SDL_SetRenderTarget(app->renderer, ex.target);
+    drawScene(app);
+    SDL_Surface* pixels = SDL_RenderReadPixels(app->renderer, nullptr);
+    if (!pixels || !ex.writer->submit(pixels))
+    {
+        SDL_Log("Export stopped at frame %d: %s", ex.frame, pixels ? "write failed" : SDL_GetError());
+        return SDL_APP_FAILURE;
+    }
+
+    if (++ex.frame % EXPORT_PROGRESS_INTERVAL == 0) SDL_Log("Exported %d / %d frames", ex.frame, ex.frames);
+    return SDL_APP_CONTINUE;
+}
+
+SDL_AppResult SDL_AppIterate(void* appstate)
+{
+    auto* app = static_cast<AppState*>(appstate);
+    if (app->exporting.writer) return iterateExport(app);
+
+    const auto now = std::chrono::steady_clock::now();
+    const bool idle = !app->force_redraw && !animating(app) && captureFrame(app) == app->presented;
+    setIdle(app, idle);
+    if (idle)
+    {
+        // Nothing to show; keep the clock current so the next real frame does not catch up on the wait
+        app->last_tick = now;
+        app->unsimulated_time = 0.0f;
+        return SDL_APP_CONTINUE;
+    }
+
+    app->profiler.beginFrame();
+
+    {
+        FrameProfiler::Zone zone(app->profiler, "load");
+        if (auto loaded = app->loader.poll()) applyLoadedSVG(app, std::move(*loaded));
+        if (app->live.takeChanged()) applyLiveDrawing(app);
+    }
+
+    const float dt = std::chrono::duration<float>(now - app->last_tick).count();
+    app->last_tick = now;
+    app->frame_time = dt;
+
+    // Advance in whole ticks so t moves by a constant step and FourierCircles can rotate instead of recompute
+    app->unsimulated_time += dt;
+    const int ticks = static_cast<int>(app->unsimulated_time / SIMULATION_TICK);
+    app->unsimulated_time -= static_cast<float>(ticks) * SIMULATION_TICK;
+
+    const float tick_time = SIMULATION_TICK * app->time_scale;
+    const int steps = app->paused ? 0 : ticks;
+    app->accumulated_time = std::fmod(app->accumulated_time + static_cast<float>(steps) * tick_time,
+                                      SIMULATION_PERIOD);
+
+    // Wrap time to 0..1 for calculation
+    const float periodT = app->accumulated_time / SIMULATION_PERIOD;
+
+    if (app->show_gallery)
+    {
+        drawGallery(app, periodT, tick_time / SIMULATION_PERIOD, steps);
+    }
+    else
+    {
+        advanceVectors(app, periodT, tick_time / SIMULATION_PERIOD, steps);
+
+        if (app->cam.follow_mode)
+        {
+            int w, h;
+            SDL_GetWindowSize(app->window, &w, &h);
+            const Vec2f window_size = {static_cast<float>(w), static_cast<float>(h)};
+            app->cam.position = window_size / 2.0f - app->current_tip * app->cam.zoom;
+        }
+
+        drawScene(app);
+    }
+
+    {
+        FrameProfiler::Zone zone(app->profiler, "ui");
+        drawUI(app);
+        drawProfiler(app);
+    }
+
+    {
+        FrameProfiler::Zone zone(app->profiler, "present");
+        SDL_RenderPresent(app->renderer);
+    }
+    app->profiler.endFrame();
 
-    SDL_RenderPresent(app->renderer);
+    app->presented = captureFrame(app);
+    app->force_redraw = false;
     return SDL_APP_CONTINUE;
 }
 
@@ -791,6 +1498,7 @@ void SDL_AppQuit(void* appstate, SDL_AppResult result)
 {
     if (const auto* app = static_cast<AppState*>(appstate))
     {
+        if (app->exporting.target) SDL_DestroyTexture(app->exporting.target);
         SDL_DestroyRenderer(app->renderer);
         SDL_DestroyWindow(app->window);
         delete app;
@@ -1,2 +1,63 @@
 #define NANOSVG_IMPLEMENTATION
-#include <nanosvg.h>
\ No newline at end of file
+#include <nanosvg.h>
+#undef NANOSVG_IMPLEMENTATION
+
+#include "svg.h"
+
+namespace svg
+{
+    namespace
+    {
+        // True when the control points are within `tol` of the chord p0-p3, so the cubic may be replaced by it
+        bool isFlat(const Vec2f& p0, const Vec2f& p1, const Vec2f& p2, const Vec2f& p3, const float tol) noexcept
+        {
+            // Upper bound on the cubic's deviation from the chord is |max(u², v²)| / 16 per axis
+            const Vec2f u = p1 * 3.0f - p0 * 2.0f - p3;
+            const Vec2f v = p2 * 3.0f - p0 - p3 * 2.0f;
+            const float dx = std::max(u.x * u.x, v.x * v.x);
+            const float dy = std::max(u.y * u.y, v.y * v.y);
+            return dx + dy <= 16.0f * tol * tol;
+        }
+
+        // Emits the end points of the chords approximating the cubic (p0 was emitted already), skipping those that
+        // repeat `last`, the previously emitted vertex
+        void flattenCubic(const Vec2f& p0, const Vec2f& p1, const Vec2f& p2, const Vec2f& p3, const float tol,
+                          const int depth, Vec2f& last, const EmitFn emit, void* context)
+        {
+            if (depth >= FLATTEN_MAX_DEPTH || isFlat(p0, p1, p2, p3, tol))
+            {
+                if ((p3 - last).length_sq() > FLATTEN_MIN_CHORD_SQ)
+                {
+                    last = p3;
+                    emit(context, p3);
+                }
+                return;
+            }
+
+            // de Casteljau split at t = 0.5
+            const Vec2f p01 = lerp(p0, p1, 0.5f);
+            const Vec2f p12 = lerp(p1, p2, 0.5f);
+            const Vec2f p23 = lerp(p2, p3, 0.5f);
+            const Vec2f p012 = lerp(p01, p12, 0.5f);
+            const Vec2f p123 = lerp(p12, p23, 0.5f);
+            const Vec2f mid = lerp(p012, p123, 0.5f);
+            flattenCubic(p0, p01, p012, mid, tol, depth + 1, last, emit, context);
+            flattenCubic(mid, p123, p23, p3, tol, depth + 1, last, emit, context);
+        }
+    }
+
+    void flattenPath(const NSVGpath& path, const float tol, const EmitFn emit, void* context)
+    {
+        const std::span<const float> pts(path.pts, static_cast<std::size_t>(path.npts) * 2u);
+        Vec2f last{pts[0], pts[1]};
+        emit(context, last);
+        for (std::size_t idx = 2; idx + 5 < pts.size(); idx += 6)
+        {
+            const Vec2f p0 = last;
+            const Vec2f p1{pts[idx + 0], pts[idx + 1]};
+            const Vec2f p2{pts[idx + 2], pts[idx + 3]};
+            const Vec2f p3{pts[idx + 4], pts[idx + 5]};
+            flattenCubic(p0, p1, p2, p3, tol, 0, last, emit, context);
+        }
+    }
+}
@@ -3,225 +3,354 @@
 #include "Vec2.h"
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <cstddef>
 #include <limits>
+#include <memory>
+#include <memory_resource>
 #include <nanosvg.h>
 #include <numeric>
+#include <optional>
 #include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace svg
 {
     using geometry::Vec2f;
 
-    struct CubicSeg
-    {
-        Vec2f p0, p1, p2, p3;
-        float length{0.0f};
-    };
-
-    // Evaluate cubic bezier at t in [0,1]
-    [[nodiscard]] static constexpr Vec2f evalCubic(const Vec2f& p0, const Vec2f& p1,
-                                                   const Vec2f& p2, const Vec2f& p3,
-                                                   const float t) noexcept
-    {
-        const float u = 1.0f - t;
-        const float uu = u * u;
-        const float tt = t * t;
-        const float b0 = uu * u;
-        const float b1 = 3.0f * uu * t;
-        const float b2 = 3.0f * u * tt;
-        const float b3 = tt * t;
-        return p0 * b0 + p1 * b1 + p2 * b2 + p3 * b3;
-    }
-
     [[nodiscard]] static inline Vec2f lerp(const Vec2f& a, const Vec2f& b,
                                            const float t) noexcept
     {
         return a + (b - a) * t;
     }
 
-    // Estimate curve length by sampling (default samples tuned for accuracy/speed).
-    [[nodiscard]] static inline float
-    estimateCubicLength(const CubicSeg& s, std::size_t samples = 32) noexcept
+    // Allocator-aware, so a PathPoly placed in a FlattenedPath keeps its points in the same memory resource
+    struct PathPoly
     {
-        if (samples < 1)
-            return 0.0f;
+        using allocator_type = std::pmr::polymorphic_allocator<>;
 
-        Vec2f prev = evalCubic(s.p0, s.p1, s.p2, s.p3, 0.0f);
-        float total = 0.0f;
+        std::pmr::vector<Vec2f> pts; // polyline vertices (in order)
+        std::pmr::vector<float>
+        cum; // cumulative distance at each vertex (same size as pts)
+        float length{0.0f};
+        bool closed{false};
+
+        PathPoly() = default;
+        PathPoly(const PathPoly&) = default;
+        PathPoly(PathPoly&&) = default;
+        PathPoly& operator=(const PathPoly&) = default;
+        PathPoly& operator=(PathPoly&&) = default;
 
-        const float invSamples = 1.0f / static_cast<float>(samples);
-        for (std::size_t i = 1; i <= samples; ++i)
+        explicit PathPoly(const allocator_type& alloc) : pts(alloc), cum(alloc)
         {
-            const float t = static_cast<float>(i) * invSamples;
-            const Vec2f cur = evalCubic(s.p0, s.p1, s.p2, s.p3, t);
-            total += (cur - prev).length();
-            prev = cur;
         }
-        return total;
-    }
 
-    struct PathPoly
+        PathPoly(const PathPoly& other, const allocator_type& alloc)
+            : pts(other.pts, alloc), cum(other.cum, alloc), length(other.length), closed(other.closed)
+        {
+        }
+
+        PathPoly(PathPoly&& other, const allocator_type& alloc)
+            : pts(std::move(other.pts), alloc), cum(std::move(other.cum), alloc), length(other.length),
+              closed(other.closed)
+        {
+        }
+    };
+
+
+    // All paths of an image flattened to polylines, independent of the final sample count. Build it once per
+    // file and resample() it as often as needed.
+    struct FlattenedPath
     {
-        std::vector<Vec2f> pts; // polyline vertices (in order)
-        std::vector<float>
-        cum; // cumulative distance at each vertex (same size as pts)
-        float length{0.0f};
-        bool closed{false};
+        std::pmr::vector<PathPoly> paths;
+        float length{0.0f}; // sum of the path lengths
+
+        FlattenedPath() = default;
+
+        explicit FlattenedPath(std::pmr::memory_resource* resource) : paths(resource)
+        {
+        }
+
+        [[nodiscard]] bool empty() const noexcept { return paths.empty(); }
     };
 
+    // Maximum distance between a cubic and its polyline, relative to the larger image dimension
+    inline constexpr float FLATTEN_TOLERANCE = 1e-4f;
+    // Subdivision depth limit, 2^16 pieces per cubic at most
+    inline constexpr int FLATTEN_MAX_DEPTH = 16;
+    // Squared distance below which a chord end point repeats the previous vertex and is dropped
+    inline constexpr float FLATTEN_MIN_CHORD_SQ = 1e-12f;
 
-    [[nodiscard]] inline std::vector<Vec2f>
-    processNSVGimage(NSVGimage* image, std::size_t number_of_points)
+    struct NSVGimageDeleter
     {
-        std::vector<Vec2f> res{};
-        if (number_of_points == 0)
-            return res;
-        if (!image)
+        void operator()(NSVGimage* image) const noexcept { nsvgDelete(image); }
+    };
+
+    using NSVGimagePtr = std::unique_ptr<NSVGimage, NSVGimageDeleter>;
+
+    // nanosvg tokenizes its input in place: `text` must be followed by a NUL and is garbage afterwards
+    [[nodiscard]] inline NSVGimagePtr parseInPlace(const std::span<char> text)
+    {
+        assert(text.data()[text.size()] == '\0');
+        return NSVGimagePtr(nsvgParse(text.data(), "px", 96.0f));
+    }
+
+    // Runs fn(i) for every i in [0, count) on the calling thread. Default for the functions below that take a
+    // parallel-for, which may be anything of the same shape, e.g. a wrapper around ThreadPool::parallelFor.
+    struct SerialFor
+    {
+        template <typename Fn>
+        void operator()(const std::size_t count, Fn&& fn) const
         {
-            res.assign(number_of_points, {0.0f, 0.0f});
-            return res;
+            for (std::size_t i = 0; i < count; ++i)
+                fn(i);
         }
+    };
+
+    // Absolute flatness tolerance for `image` from one relative to its larger dimension
+    [[nodiscard]] inline float flattenTolerance(const NSVGimage& image, const float tolerance) noexcept
+    {
+        return tolerance * std::max({image.width, image.height, 1.0f});
+    }
 
-        // 1) collect cubic segments and estimate per-segment lengths
-        std::vector<std::vector<CubicSeg>> pathSegs;
-        pathSegs.reserve(64);
-        float totalLenEstimate = 0.0f;
+    using EmitFn = void (*)(void* context, const Vec2f& point);
+
+    // Emits the polyline of one nanosvg path, start point first, each cubic subdivided until it is flat to within
+    // `tol`. Defined in svg.cpp so that every caller runs the same compiled subdivision: the counting and the
+    // writing pass below must agree to the last vertex, which separately inlined copies do not guarantee once the
+    // compiler contracts their floating point differently.
+    void flattenPath(const NSVGpath& path, float tol, EmitFn emit, void* context);
+
+    template <typename Emit>
+    inline void flattenPath(const NSVGpath& path, const float tol, Emit&& emit)
+    {
+        auto* target = &emit;
+        flattenPath(path, tol, [](void* context, const Vec2f& point)
+        {
+            (*static_cast<decltype(target)>(context))(point);
+        }, target);
+    }
 
-        for (NSVGshape* shape = image->shapes; shape != nullptr;
-             shape = shape->next)
+    // The paths of `image` that have a segment at all
+    inline void collectPaths(const NSVGimage& image, std::vector<const NSVGpath*>& paths)
+    {
+        paths.clear();
+        for (const NSVGshape* shape = image.shapes; shape != nullptr; shape = shape->next)
         {
-            for (NSVGpath* path = shape->paths; path != nullptr; path = path->next)
+            for (const NSVGpath* path = shape->paths; path != nullptr; path = path->next)
             {
-                const int npts = path->npts;
-                if (npts < 2)
-                    continue;
-
-                const float* raw_pts = path->pts;
-                const std::size_t float_count = static_cast<std::size_t>(npts) * 2u;
-                std::span<const float> pts(raw_pts, float_count);
-
-                Vec2f cur{pts[0], pts[1]};
-                std::size_t idx = 2;
-
-                std::vector<CubicSeg> segs;
-                segs.reserve(8);
-
-                while (idx + 5 < pts.size())
-                {
-                    CubicSeg s{};
-                    s.p0 = cur;
-                    s.p1 = Vec2f{pts[idx + 0], pts[idx + 1]};
-                    s.p2 = Vec2f{pts[idx + 2], pts[idx + 3]};
-                    s.p3 = Vec2f{pts[idx + 4], pts[idx + 5]};
-
-                    s.length = estimateCubicLength(s, 32);
-                    if (s.length > 1e-8f)
-                    {
-                        totalLenEstimate += s.length;
-                        segs.emplace_back(s);
-                    }
-
-                    cur = s.p3;
-                    idx += 6;
-                }
-
-                if (!segs.empty())
-                    pathSegs.emplace_back(std::move(segs));
+                if (path->npts >= 2)
+                    paths.push_back(path);
             }
         }
+    }
 
-        if (pathSegs.empty() || totalLenEstimate <= 0.0f)
+    // First pass over the paths, one per parallelFor index: the vertex count each one flattens to
+    template <typename ParallelFor = SerialFor>
+    inline void countVertices(const std::span<const NSVGpath* const> paths, const float tol,
+                              std::vector<std::size_t>& counts, ParallelFor&& parallelFor = {})
+    {
+        counts.resize(paths.size());
+        parallelFor(paths.size(), [&](const std::size_t i)
         {
-            nsvgDelete(image);
-            res.assign(number_of_points, {0.0f, 0.0f});
-            return res;
-        }
-
-        // 2) decide oversampling step (common ds across all segs)
-        constexpr float oversample_factor = 8.0f;
-        const float ds =
-            std::max(totalLenEstimate /
-                     (static_cast<float>(number_of_points) * oversample_factor),
-                     std::numeric_limits<float>::epsilon());
-
-        // 3) build polylines for each path (oversample each cubic proportional to its
-        // length)
-        std::vector<PathPoly> paths;
-        paths.reserve(pathSegs.size());
+            std::size_t n = 0;
+            flattenPath(*paths[i], tol, [&n](const Vec2f&) { ++n; });
+            counts[i] = n;
+        });
+    }
 
-        constexpr float eps2 = 1e-12f;
+    // Arena bytes writePaths() takes for these vertex counts, alignment padding included
+    [[nodiscard]] inline std::size_t flattenedBytes(const std::span<const std::size_t> counts) noexcept
+    {
+        std::size_t bytes = (counts.size() + 1) * sizeof(PathPoly) + alignof(std::max_align_t);
+        for (const std::size_t n : counts)
+            bytes += n * (sizeof(Vec2f) + sizeof(float)) + 2 * alignof(std::max_align_t);
+        return bytes;
+    }
 
-        for (const auto& segs : pathSegs)
+    // Second pass: sizes every polyline from `counts` out of out's memory resource on the calling thread, then
+    // fills them in parallel, each path into its own preallocated storage. Paths without drawable length are
+    // dropped and the total is summed in path order, so the result does not depend on the schedule.
+    template <typename ParallelFor = SerialFor>
+    inline void writePaths(const std::span<const NSVGpath* const> paths, const std::span<const std::size_t> counts,
+                           const float tol, FlattenedPath& out, ParallelFor&& parallelFor = {})
+    {
+        const std::size_t first = out.paths.size();
+        out.paths.reserve(first + paths.size());
+        for (std::size_t i = 0; i < paths.size(); ++i)
         {
-            PathPoly poly;
-            poly.closed = false;
+            PathPoly& poly = out.paths.emplace_back();
+            poly.closed = paths[i]->closed != 0;
+            poly.pts.resize(counts[i]);
+            poly.cum.resize(counts[i]);
+        }
 
-            for (const auto& [p0, p1, p2, p3, length] : segs)
+        parallelFor(paths.size(), [&](const std::size_t i)
+        {
+            PathPoly& poly = out.paths[first + i];
+            Vec2f* cursor = poly.pts.data();
+            flattenPath(*paths[i], tol, [&cursor](const Vec2f& p) { *cursor++ = p; });
+            assert(cursor == poly.pts.data() + counts[i]);
+
+            const std::size_t N = poly.pts.size();
+            if (N < 2)
+                return;
+            poly.cum[0] = 0.0f;
+            for (std::size_t k = 1; k < N; ++k)
             {
-                const int k =
-                    std::max(2, static_cast<int>(std::lround(std::ceil(length / ds))));
-                const auto denom = static_cast<float>(k - 1);
-                // j from 0..k-1 inclusive
-                for (int j = 0; j < k; ++j)
-                {
-                    const float t = (denom > 0.0f) ? (static_cast<float>(j) / denom) : 0.0f;
-                    const Vec2f p = evalCubic(p0, p1, p2, p3, t);
-                    if (poly.pts.empty() || (p - poly.pts.back()).length_sq() > eps2)
-                    {
-                        poly.pts.push_back(p);
-                    }
-                }
+                poly.cum[k] =
+                    poly.cum[k - 1] + (poly.pts[k] - poly.pts[k - 1]).length();
             }
+            poly.length = poly.cum.back();
+        });
+
+        const auto kept = std::remove_if(out.paths.begin() + static_cast<std::ptrdiff_t>(first), out.paths.end(),
+                                         [](const PathPoly& poly) { return !(poly.length > 0.0f); });
+        out.paths.erase(kept, out.paths.end());
+        for (std::size_t i = first; i < out.paths.size(); ++i)
+            out.length += out.paths[i].length;
+    }
+
+    // Appends the paths of `image` to `out`, allocating from out's memory resource. Each cubic is subdivided
+    // adaptively until it is flat to within `tolerance` (relative to the image size), so straight runs cost one
+    // vertex and only curved parts are refined. Paths without drawable length are skipped.
+    template <typename ParallelFor = SerialFor>
+    inline void flattenInto(const NSVGimage& image, const float tolerance, FlattenedPath& out,
+                            ParallelFor&& parallelFor = {})
+    {
+        const float tol = flattenTolerance(image, tolerance);
+        std::vector<const NSVGpath*> paths;
+        std::vector<std::size_t> counts;
+        collectPaths(image, paths);
+        countVertices(paths, tol, counts, parallelFor);
+        writePaths(paths, counts, tol, out, parallelFor);
+    }
+
+    // Takes ownership of `image` and flattens it on the default memory resource. Returns an empty FlattenedPath if
+    // the image is null or has no drawable length.
+    [[nodiscard]] inline FlattenedPath
+    flattenNSVGimage(NSVGimage* image, const float tolerance = FLATTEN_TOLERANCE)
+    {
+        const NSVGimagePtr owned(image);
+        FlattenedPath res{};
+        if (owned)
+            flattenInto(*owned, tolerance, res);
+        return res;
+    }
 
-            if (poly.pts.size() >= 2)
+    // Flattens one image after another into a single arena that is kept across images: sized exactly from the
+    // counting pass, grown when an image needs more and otherwise only rewound, so loading a file with thousands of
+    // small paths costs no allocator traffic once the arena is large enough. Both passes run per path through the
+    // given parallel-for. Each flatten() invalidates the previous result.
+    class Flattener
+    {
+    public:
+        Flattener() = default;
+        Flattener(const Flattener&) = delete;
+        Flattener& operator=(const Flattener&) = delete;
+
+        // Takes ownership of `image`, which is freed as soon as its paths are copied out
+        template <typename ParallelFor = SerialFor>
+        const FlattenedPath& flatten(NSVGimage* image, const float tolerance = FLATTEN_TOLERANCE,
+                                     ParallelFor&& parallelFor = {})
+        {
+            const NSVGimagePtr owned(image);
+            if (!owned)
             {
-                const std::size_t N = poly.pts.size();
-                poly.cum.resize(N);
-                poly.cum[0] = 0.0f;
-                for (std::size_t i = 1; i < N; ++i)
-                {
-                    poly.cum[i] =
-                        poly.cum[i - 1] + (poly.pts[i] - poly.pts[i - 1]).length();
-                }
-                poly.length = poly.cum.back();
-                if (poly.length > 0.0f)
-                    paths.emplace_back(std::move(poly));
+                m_result.reset();
+                m_arena.reset();
+                return result();
             }
+            return flatten(*owned, tolerance, parallelFor);
+        }
+
+        // Leaves `image` to the caller, e.g. to flatten it again later without parsing it again
+        template <typename ParallelFor = SerialFor>
+        const FlattenedPath& flatten(const NSVGimage& image, const float tolerance = FLATTEN_TOLERANCE,
+                                     ParallelFor&& parallelFor = {})
+        {
+            m_result.reset();
+            m_arena.reset();
+
+            const float tol = flattenTolerance(image, tolerance);
+            collectPaths(image, m_paths);
+            countVertices(m_paths, tol, m_counts, parallelFor);
+
+            const std::size_t bytes = flattenedBytes(m_counts);
+            if (bytes > m_buffer.size())
+                m_buffer.resize(std::max(bytes, 2 * m_buffer.size()));
+            m_arena.emplace(m_buffer.data(), m_buffer.size());
+            m_result.emplace(&*m_arena);
+
+            writePaths(m_paths, m_counts, tol, *m_result, parallelFor);
+            return *m_result;
+        }
+
+        template <typename ParallelFor = SerialFor>
+        const FlattenedPath& flattenString(const std::string_view svg_string_view, ParallelFor&& parallelFor = {})
+        {
+            // nanosvg parses in place, the copy keeps its capacity across calls
+            m_text.assign(svg_string_view);
+            return flatten(parseInPlace(m_text).release(), FLATTEN_TOLERANCE, parallelFor);
         }
 
-        nsvgDelete(image);
+        // Result of the last flatten(), empty before the first
+        [[nodiscard]] const FlattenedPath& result() const noexcept
+        {
+            return m_result ? *m_result : m_empty;
+        }
+
+    private:
+        std::vector<std::byte> m_buffer;
+        std::optional<std::pmr::monotonic_buffer_resource> m_arena; // over m_buffer, heap beyond it
+        std::optional<FlattenedPath> m_result; // declared after m_arena so it is destroyed first
+        FlattenedPath m_empty;
+        std::string m_text;
+        std::vector<const NSVGpath*> m_paths;
+        std::vector<std::size_t> m_counts;
+    };
+
+    // Distributes `number_of_points` along all paths proportionally to path length. An empty path yields zeros of
+    // the requested size. Paths are sampled through `parallelFor`, each into its own slice of the output.
+    template <typename ParallelFor = SerialFor>
+    [[nodiscard]] std::vector<Vec2f>
+    resample(const FlattenedPath& flattened, const std::size_t number_of_points, ParallelFor&& parallelFor = {})
+    {
+        std::vector<Vec2f> res{};
+        if (number_of_points == 0)
+            return res;
 
+        const auto& paths = flattened.paths;
+        const float totalLen = flattened.length;
         if (paths.empty())
         {
             res.assign(number_of_points, {0.0f, 0.0f});
             return res;
         }
-
-        // recompute accurate total length from polylines
-        float totalLen = 0.0f;
-        for (const auto& p : paths)
-            totalLen += p.length;
         if (totalLen <= 0.0f)
         {
             res.assign(number_of_points, paths.front().pts.front());
             return res;
         }
 
+        // Per-path temporaries live on the stack unless the image has a great many paths
+        std::array<std::byte, 4096> scratch_buffer;
+        std::pmr::monotonic_buffer_resource scratch(scratch_buffer.data(), scratch_buffer.size());
+
         // 4) Allocate counts per path proportional to path length (balanced rounding)
         const std::size_t P = paths.size();
-        std::vector<std::size_t> counts(P, 0);
+        std::pmr::vector<std::size_t> counts(P, 0, &scratch);
 
         struct Part
         {
             double frac;
             std::size_t idx;
         };
-        std::vector<Part> fracParts;
+        std::pmr::vector<Part> fracParts(&scratch);
         fracParts.reserve(P);
 
         std::size_t baseSum = 0;
@@ -254,7 +383,7 @@ namespace svg
         if (finalCount < number_of_points)
         {
             // give remaining to longest paths
-            std::vector<std::pair<float, std::size_t>> byLen;
+            std::pmr::vector<std::pair<float, std::size_t>> byLen(&scratch);
             byLen.reserve(P);
             for (std::size_t i = 0; i < P; ++i)
                 byLen.emplace_back(paths[i].length, i);
@@ -268,7 +397,7 @@ namespace svg
         else if (finalCount > number_of_points)
         {
             // trim from shortest paths
-            std::vector<std::pair<float, std::size_t>> byLen;
+            std::pmr::vector<std::pair<float, std::size_t>> byLen(&scratch);
             byLen.reserve(P);
             for (std::size_t i = 0; i < P; ++i)
                 byLen.emplace_back(paths[i].length, i);
@@ -284,40 +413,41 @@ namespace svg
             }
         }
 
-        // 5) Sample each path by inverse arc-length using binary search on its
-        // polyline.
-        res.reserve(number_of_points);
-        for (std::size_t i = 0; i < P; ++i)
+        // 5) Sample each path by inverse arc-length, into the slice of `res` its count reserves. Sample positions
+        // increase monotonically, so a single cursor walking poly.cum in step with them replaces a binary search
+        // per sample.
+        std::pmr::vector<std::size_t> offsets(P, 0, &scratch);
+        std::exclusive_scan(counts.begin(), counts.end(), offsets.begin(), std::size_t{0});
+        res.resize(offsets.back() + counts.back());
+        parallelFor(P, [&](const std::size_t i)
         {
             const auto& poly = paths[i];
             const std::size_t n = counts[i];
             if (n == 0)
-                continue;
+                return;
 
             const float step = poly.length / static_cast<float>(n);
             const float offset =
                 0.5f * step; // center samples to avoid endpoint clustering
 
+            const std::size_t last = poly.cum.size() - 1;
+            std::size_t idx1 = 1;
             for (std::size_t j = 0; j < n; ++j)
             {
                 float s = offset + static_cast<float>(j) * step;
                 if (s >= poly.length)
                     s = std::nextafter(poly.length, 0.0f);
 
-                auto it = std::ranges::upper_bound(poly.cum, s);
-                auto idx1 = static_cast<std::size_t>(std::distance(poly.cum.begin(), it));
-                if (idx1 == 0)
-                    idx1 = 1;
-                if (idx1 >= poly.cum.size())
-                    idx1 = poly.cum.size() - 1;
+                // first vertex past s, as upper_bound would find it
+                while (idx1 < last && poly.cum[idx1] <= s)
+                    ++idx1;
                 const std::size_t idx0 = idx1 - 1;
 
                 const float segLen = std::max(poly.cum[idx1] - poly.cum[idx0], 1e-12f);
                 const float t = (s - poly.cum[idx0]) / segLen;
-                const Vec2f p = lerp(poly.pts[idx0], poly.pts[idx1], t);
-                res.emplace_back(p);
+                res[offsets[i] + j] = lerp(poly.pts[idx0], poly.pts[idx1], t);
             }
-        }
+        });
 
         assert(res.size() == number_of_points ||
             res.size() ==
@@ -325,12 +455,24 @@ namespace svg
         return res;
     }
 
-    [[nodiscard]] inline std::vector<Vec2f>
-    readSVGCurveFromString(const std::string_view svg_string_view, const std::size_t number_of_points)
+    [[nodiscard]] inline FlattenedPath flattenSVGFromString(const std::string_view svg_string_view)
     {
         std::string svg_string{svg_string_view};
         NSVGimage* image = nsvgParse(svg_string.data(), "px", 96.0f);
-        return processNSVGimage(image, number_of_points);
+        return flattenNSVGimage(image);
+    }
+
+    [[nodiscard]] inline FlattenedPath flattenSVGFromFile(const std::string& filename)
+    {
+        // parse image (caller must ensure NANOSVG_IMPLEMENTATION compiled in one TU)
+        NSVGimage* image = nsvgParseFromFile(filename.c_str(), "px", 96.0f);
+        return flattenNSVGimage(image);
+    }
+
+    [[nodiscard]] inline std::vector<Vec2f>
+    readSVGCurveFromString(const std::string_view svg_string_view, const std::size_t number_of_points)
+    {
+        return resample(flattenSVGFromString(svg_string_view), number_of_points);
     }
 
     // Read an SVG path and produce `number_of_points` points distributed along all
@@ -339,9 +481,6 @@ namespace svg
     [[nodiscard]] inline std::vector<Vec2f>
     readSVGCurveFromFile(const std::string& filename, const std::size_t number_of_points)
     {
-        // parse image (caller must ensure NANOSVG_IMPLEMENTATION compiled in one TU)
-        NSVGimage* image = nsvgParseFromFile(filename.c_str(), "px", 96.0f);
-
-        return processNSVGimage(image, number_of_points);
+        return resample(flattenSVGFromFile(filename), number_of_points);
     }
 } // namespace svg
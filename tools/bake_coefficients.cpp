@@ -0,0 +1,105 @@
+// Tool to precompute the coefficient cache snapshot of an SVG, so the app can start without parsing or transforming it
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include "CoefficientCache.h"
+#include "FourierCircles.h"
+#include "svg.h"
+
+static bool parse_number(const std::string& text, double& out)
+{
+    try
+    {
+        std::size_t used = 0;
+        out = std::stod(text, &used);
+        return used == text.size();
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        if (argc != 6)
+        {
+            std::cerr << "Usage: " << argv[0] << " <input_svg> <output_file> <sample_count> <offset_x> <scale>\n";
+            return 1;
+        }
+
+        const std::filesystem::path input_path = argv[1];
+        const std::filesystem::path output_path = argv[2];
+        double samples = 0.0, offset = 0.0, factor = 0.0;
+        if (!parse_number(argv[3], samples) || samples < 1.0 || samples != static_cast<int>(samples) ||
+            !parse_number(argv[4], offset) || !parse_number(argv[5], factor))
+        {
+            std::cerr << "Error: sample_count must be a positive integer, offset_x and scale numbers\n";
+            return 2;
+        }
+        const int sample_count = static_cast<int>(samples);
+        const auto offset_x = static_cast<float>(offset);
+        const auto scale = static_cast<float>(factor);
+
+        std::ifstream ifs(input_path, std::ios::binary);
+        if (!ifs)
+        {
+            std::error_code ec(errno, std::generic_category());
+            std::cerr << std::format("Error: cannot open input file '{}': {}\n", input_path.string(), ec.message());
+            return 3;
+        }
+        std::ostringstream ss;
+        ss << ifs.rdbuf();
+        const std::string text = ss.str();
+        ifs.close();
+
+        // Same pipeline as SvgLoader
+        const svg::FlattenedPath flattened = svg::flattenSVGFromString(text);
+        if (flattened.empty())
+        {
+            std::cerr << std::format("Error: '{}' has no drawable paths\n", input_path.string());
+            return 4;
+        }
+
+        auto points = svg::resample(flattened, static_cast<std::size_t>(sample_count));
+        for (auto& point : points)
+        {
+            point.x += offset_x;
+            point *= scale;
+        }
+
+        FourierCircles circles;
+        circles.calculateCoefficients(points);
+
+        const auto key = coefficient_cache::makeKey(text, sample_count, offset_x, scale);
+        const auto data = coefficient_cache::serialize(key, points, circles);
+
+        std::ofstream ofs(output_path, std::ios::binary | std::ios::trunc);
+        if (!ofs)
+        {
+            std::error_code ec(errno, std::generic_category());
+            std::cerr << std::format("Error: cannot create output file '{}': {}\n", output_path.string(), ec.message());
+            return 5;
+        }
+        ofs.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        ofs.close();
+
+        std::cout << std::format("Generated {} ({} coefficients, {} bytes)\n", output_path.string(), circles.size(),
+                                 data.size());
+        return 0;
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "Unhandled exception: " << ex.what() << '\n';
+        return 99;
+    }
+}
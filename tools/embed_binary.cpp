@@ -1,4 +1,10 @@
-// Tool to embed binary files as C++ headers
+// Tool to embed binary files into the build. Writes a header declaring `<variable_name>` as a span over the bytes
+// and, next to it, a source file defining them in one of three ways:
+//   array   a literal initializer, works everywhere but is slow to compile for large files
+//   embed   a C23 #embed directive, read by the compiler itself
+//   incbin  an assembler .incbin directive (ELF toolchains)
+// The header does not depend on the file's contents and is only rewritten when it changes, so editing an asset
+// recompiles the one generated source file and nothing that includes the header.
 #include <algorithm>
 #include <cstddef>
 #include <filesystem>
@@ -8,6 +14,7 @@
 #include <iterator>
 #include <ranges>
 #include <span>
+#include <sstream>
 #include <string>
 #include <string_view>
 #include <system_error>
@@ -15,41 +22,61 @@
 
 using namespace std::literals;
 
-static constexpr std::string make_header_guard(std::string_view varname)
+// Path as a string literal body, for #embed and .incbin
+static std::string escape_path(const std::filesystem::path& path)
 {
-    std::string out = "EMBEDDED_";
-    out.reserve(out.size() + varname.size() + 2);
-    for (char c : varname)
+    std::string out;
+    for (const char c : std::filesystem::absolute(path).generic_string())
     {
-        if (c >= 'a' && c <= 'z') out.push_back(char(c - 'a' + 'A'));
-        else if ((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) out.push_back(c);
-        else out.push_back('_');
+        if (c == '"' || c == '\\') out.push_back('\\');
+        out.push_back(c);
     }
-    out += "_H";
     return out;
 }
 
+// Leaves an identical file untouched so its timestamp does not trigger rebuilds
+static bool write_if_changed(const std::filesystem::path& path, const std::string& contents)
+{
+    {
+        std::ifstream ifs(path, std::ios::binary);
+        if (ifs)
+        {
+            std::ostringstream ss;
+            ss << ifs.rdbuf();
+            if (ss.str() == contents) return true;
+        }
+    }
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    return ofs && ofs.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+}
+
 int main(int argc, char* argv[])
 {
     try
     {
-        if (argc != 4)
+        if (argc != 4 && argc != 5)
         {
-            std::cerr << "Usage: " << argv[0] << " <input_file> <output_file> <variable_name>\n";
+            std::cerr << "Usage: " << argv[0] << " <input_file> <output_header> <variable_name> [array|embed|incbin]\n";
             return 1;
         }
 
         const std::filesystem::path input_path = argv[1];
-        const std::filesystem::path output_path = argv[2];
+        const std::filesystem::path header_path = argv[2];
         const std::string var_name = argv[3];
+        const std::string_view mode = argc == 5 ? std::string_view(argv[4]) : "array"sv;
 
         if (var_name.empty())
         {
             std::cerr << "Error: variable_name must be non-empty\n";
             return 2;
         }
+        if (mode != "array" && mode != "embed" && mode != "incbin")
+        {
+            std::cerr << std::format("Error: unknown mode '{}'\n", mode);
+            return 2;
+        }
 
-        // Read file into buffer
+        // Read file into buffer; #embed and .incbin do not need the bytes but reading them checks the input
         std::ifstream ifs(input_path, std::ios::binary | std::ios::ate);
         if (!ifs)
         {
@@ -70,43 +97,78 @@ int main(int argc, char* argv[])
         }
         ifs.close();
 
-        // Prepare header contents
         const std::string filename = input_path.filename().string();
+        std::filesystem::path source_path = header_path;
+        source_path.replace_extension(".cpp");
 
-        std::ofstream ofs(output_path, std::ios::trunc);
-        if (!ofs)
-        {
-            std::error_code ec(errno, std::generic_category());
-            std::cerr << std::format("Error: cannot create output file '{}': {}\n", output_path.string(), ec.message());
-            return 5;
-        }
+        std::string header;
+        header += std::format("// Auto-generated from {}\n", filename);
+        header += "#pragma once\n\n";
+        header += "#include <span>\n\n";
+        header += std::format("// Defined in {}\n", source_path.filename().string());
+        header += std::format("extern const std::span<const unsigned char> {};\n", var_name);
 
-        ofs << std::format("// Auto-generated from {}\n", filename);
-        ofs << "#pragma once\n\n";
-        ofs << "#include <cstdint>\n#include <cstddef>\n\n";
-        ofs << std::format("inline constexpr unsigned char {}[] = {{\n", var_name);
+        std::string source;
+        source += std::format("// Auto-generated from {}\n", filename);
+        source += std::format("#include \"{}\"\n\n", header_path.filename().string());
 
-        // Write bytes 12 per line
-        for (size_t i = 0; i < data.size(); ++i)
+        if (mode == "incbin")
+        {
+            source += "__asm__(\n";
+            source += "    \".pushsection .rodata\\n\"\n";
+            source += "    \".balign 16\\n\"\n";
+            source += std::format("    \".globl {0}_begin\\n.hidden {0}_begin\\n{0}_begin:\\n\"\n", var_name);
+            source += std::format("    \".incbin \\\"{}\\\"\\n\"\n", escape_path(input_path));
+            source += std::format("    \".globl {0}_end\\n.hidden {0}_end\\n{0}_end:\\n\"\n", var_name);
+            source += "    \".popsection\\n\");\n\n";
+            source += std::format("extern \"C\" const unsigned char {0}_begin[];\nextern \"C\" const unsigned char {0}_end[];\n\n",
+                                  var_name);
+            source += std::format("const std::span<const unsigned char> {0}{{{0}_begin, {0}_end}};\n", var_name);
+        }
+        else
         {
-            constexpr size_t per_line = 12;
-            if (i % per_line == 0) ofs << "    ";
-            const unsigned val = static_cast<unsigned>(std::to_integer<int>(data[i])) & 0xFFu;
-            ofs << std::format("0x{:02X}", val);
-            if (i + 1 < data.size())
+            if (mode == "embed")
+            {
+                // Still an extension in C++23 mode
+                source += "#if defined(__clang__)\n";
+                source += "#pragma clang diagnostic ignored \"-Wunknown-warning-option\"\n";
+                source += "#pragma clang diagnostic ignored \"-Wc23-extensions\"\n";
+                source += "#endif\n\n";
+            }
+            source += std::format("alignas(16) static constexpr unsigned char {}_bytes[] = {{\n", var_name);
+            if (mode == "embed")
+            {
+                source += std::format("#embed \"{}\"\n", escape_path(input_path));
+            }
+            else
             {
-                ofs << ',';
-                if ((i + 1) % per_line == 0) ofs << '\n';
-                else ofs << ' ';
+                // Write bytes 12 per line
+                for (size_t i = 0; i < data.size(); ++i)
+                {
+                    constexpr size_t per_line = 12;
+                    if (i % per_line == 0) source += "    ";
+                    const unsigned val = static_cast<unsigned>(std::to_integer<int>(data[i])) & 0xFFu;
+                    source += std::format("0x{:02X}", val);
+                    if (i + 1 < data.size())
+                    {
+                        source += ',';
+                        source += (i + 1) % per_line == 0 ? '\n' : ' ';
+                    }
+                }
+                source += '\n';
             }
+            source += "};\n\n";
+            source += std::format("constinit const std::span<const unsigned char> {0}{{{0}_bytes}};\n", var_name);
         }
 
-        ofs << "\n};\n\n";
-        ofs << std::format("inline constexpr std::size_t {}_len = {};\n", var_name, data.size());
-
-        ofs.close();
+        if (!write_if_changed(header_path, header) || !write_if_changed(source_path, source))
+        {
+            std::error_code ec(errno, std::generic_category());
+            std::cerr << std::format("Error: cannot write '{}': {}\n", header_path.string(), ec.message());
+            return 5;
+        }
 
-        std::cout << std::format("Generated {} ({} bytes)\n", output_path.string(), data.size());
+        std::cout << std::format("Generated {} ({} bytes, {})\n", source_path.string(), data.size(), mode);
         return 0;
     }
     catch (const std::exception& ex)
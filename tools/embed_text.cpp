@@ -1,4 +1,6 @@
-// Tool to embed text files as C++ headers
+// Tool to embed text files into the build. Like embed_binary it writes a header declaring `<variable_name>` and a
+// source file next to it holding the text as a literal (array), through #embed (embed) or through .incbin (incbin).
+// The text is writable and followed by a NUL, so a parser that tokenizes in place can run on it without a copy.
 #include <cerrno>
 #include <filesystem>
 #include <fstream>
@@ -9,26 +11,61 @@
 #include <string_view>
 #include <system_error>
 
+using namespace std::literals;
+
+// Path as a string literal body, for #embed and .incbin
+static std::string escape_path(const std::filesystem::path& path)
+{
+    std::string out;
+    for (const char c : std::filesystem::absolute(path).generic_string())
+    {
+        if (c == '"' || c == '\\') out.push_back('\\');
+        out.push_back(c);
+    }
+    return out;
+}
+
+// Leaves an identical file untouched so its timestamp does not trigger rebuilds
+static bool write_if_changed(const std::filesystem::path& path, const std::string& contents)
+{
+    {
+        std::ifstream ifs(path, std::ios::binary);
+        if (ifs)
+        {
+            std::ostringstream ss;
+            ss << ifs.rdbuf();
+            if (ss.str() == contents) return true;
+        }
+    }
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    return ofs && ofs.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+}
 
 int main(int argc, char* argv[])
 {
     try
     {
-        if (argc != 4)
+        if (argc != 4 && argc != 5)
         {
-            std::cerr << "Usage: " << argv[0] << " <input_file> <output_file> <variable_name>\n";
+            std::cerr << "Usage: " << argv[0] << " <input_file> <output_header> <variable_name> [array|embed|incbin]\n";
             return 1;
         }
 
         const std::filesystem::path input_path = argv[1];
-        const std::filesystem::path output_path = argv[2];
+        const std::filesystem::path header_path = argv[2];
         const std::string var_name = argv[3];
+        const std::string_view mode = argc == 5 ? std::string_view(argv[4]) : "array"sv;
 
         if (var_name.empty())
         {
             std::cerr << "Error: variable_name must be non-empty\n";
             return 2;
         }
+        if (mode != "array" && mode != "embed" && mode != "incbin")
+        {
+            std::cerr << std::format("Error: unknown mode '{}'\n", mode);
+            return 2;
+        }
 
         // Read entire text file
         std::ifstream ifs(input_path);
@@ -44,29 +81,64 @@ int main(int argc, char* argv[])
         ifs.close();
 
         const std::string filename = input_path.filename().string();
+        std::filesystem::path source_path = header_path;
+        source_path.replace_extension(".cpp");
+
+        std::string header;
+        header += std::format("// Auto-generated from {}\n", filename);
+        header += "#pragma once\n\n";
+        header += "#include <span>\n\n";
+        header += std::format("// Defined in {}. Writable, with a NUL after its last character.\n",
+                              source_path.filename().string());
+        header += std::format("extern const std::span<char> {};\n", var_name);
 
-        std::ofstream ofs(output_path, std::ios::trunc);
-        if (!ofs)
+        std::string source;
+        source += std::format("// Auto-generated from {}\n", filename);
+        source += std::format("#include \"{}\"\n\n", header_path.filename().string());
+
+        if (mode == "incbin")
+        {
+            source += "__asm__(\n";
+            source += "    \".pushsection .data\\n\"\n";
+            source += std::format("    \".globl {0}_begin\\n.hidden {0}_begin\\n{0}_begin:\\n\"\n", var_name);
+            source += std::format("    \".incbin \\\"{}\\\"\\n\"\n", escape_path(input_path));
+            source += std::format("    \".globl {0}_end\\n.hidden {0}_end\\n{0}_end:\\n\"\n", var_name);
+            source += "    \".byte 0\\n\"\n";
+            source += "    \".popsection\\n\");\n\n";
+            source += std::format("extern \"C\" char {0}_begin[];\nextern \"C\" char {0}_end[];\n\n", var_name);
+            source += std::format("const std::span<char> {0}{{{0}_begin, {0}_end}};\n", var_name);
+        }
+        else if (mode == "embed")
+        {
+            // Bytes above 0x7F would narrow into char, so the buffer is unsigned
+            source += "#if defined(__clang__)\n";
+            source += "#pragma clang diagnostic ignored \"-Wunknown-warning-option\"\n";
+            source += "#pragma clang diagnostic ignored \"-Wc23-extensions\"\n";
+            source += "#endif\n\n";
+            source += std::format("static unsigned char {}_bytes[] = {{\n", var_name);
+            source += std::format("#embed \"{}\" suffix(, 0)\n", escape_path(input_path));
+            source += "};\n\n";
+            source += std::format("const std::span<char> {0}{{reinterpret_cast<char*>({0}_bytes), sizeof({0}_bytes) - 1}};\n",
+                                  var_name);
+        }
+        else
+        {
+            // Use raw string literal with a fixed delimiter; it's very unlikely to appear in the text
+            constexpr std::string_view delim = "TXT_CONTENT";
+            source += std::format("static char {}_text[] = R\"{}(\n", var_name, delim);
+            source += text;
+            source += std::format("){}\";\n\n", delim);
+            source += std::format("constinit const std::span<char> {0}{{{0}_text, sizeof({0}_text) - 1}};\n", var_name);
+        }
+
+        if (!write_if_changed(header_path, header) || !write_if_changed(source_path, source))
         {
             std::error_code ec(errno, std::generic_category());
-            std::cerr << std::format("Error: cannot create output file '{}': {}\n", output_path.string(), ec.message());
+            std::cerr << std::format("Error: cannot write '{}': {}\n", header_path.string(), ec.message());
             return 4;
         }
 
-        ofs << std::format("// Auto-generated from {}\n", filename);
-        ofs << "#pragma once\n\n";
-        ofs << "#include <string_view>\n\n";
-
-        // Use raw string literal with a unique delimiter derived from variable name
-        std::string delim = "TXT_CONTENT";
-        // If var_name may contain characters that could collide, keep delim fixed; it's very unlikely to appear.
-        ofs << std::format("inline constexpr std::string_view {} = R\"{}(\n", var_name, delim);
-        ofs << text;
-        ofs << std::format("){}\";\n", delim);
-
-        ofs.close();
-
-        std::cout << std::format("Generated {} ({} characters)\n", output_path.string(), text.size());
+        std::cout << std::format("Generated {} ({} characters, {})\n", source_path.string(), text.size(), mode);
         return 0;
     }
     catch (const std::exception& ex)